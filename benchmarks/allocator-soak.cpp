@@ -0,0 +1,156 @@
+// Long-running allocator soak: builds a UI whose ImGui state churns (windows opening and
+// closing, growing and shrinking text, tables, transient scratch buffers) and checks that
+// the memory reserved by the selected allocator stays flat. Also destroys and recreates a
+// second renderer periodically, whose heap must not outlive it. Prints JSON results.
+//
+//   qtimgui_allocator_soak --allocator arena --frames 100000
+//
+// Exits with status 2 when reserved memory grew by more than --max-growth percent between
+// the end of the first half of the run and its end, or when heaps leaked.
+// Runs without a display with QT_QPA_PLATFORM=offscreen, on the software backend.
+
+#include <QtImGui.h>
+#include <ImGuiAllocator.h>
+#include <ImGuiRenderer.h>
+#include <imgui.h>
+#include <QCommandLineParser>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+void buildUi(int frame, std::string &log)
+{
+    // Windows come and go, their ImVectors and draw lists are allocated and freed again
+    for (int w = 0; w < 8; w++) {
+        if ((frame / 97 + w) % 3 == 0)
+            continue;
+        char title[32];
+        std::snprintf(title, sizeof(title), "Window %d", (frame / 997 + w) % 24);
+        ImGui::SetNextWindowPos(ImVec2(float(w % 4) * 240.0f, float(w / 4) * 300.0f), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(ImVec2(230.0f, 290.0f), ImGuiCond_Always);
+        ImGui::Begin(title);
+
+        const int rows = 5 + (frame + w * 13) % 60;
+        if (ImGui::BeginTable("table", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable)) {
+            for (int r = 0; r < rows; r++) {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", r);
+                ImGui::TableNextColumn();
+                ImGui::Text("row %d of %d", r, rows);
+                ImGui::TableNextColumn();
+                ImGui::ProgressBar(float(r) / rows);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::End();
+    }
+
+    // A text log growing then cleared, as in a console window
+    log += "frame " + std::to_string(frame) + "\n";
+    if (log.size() > 64 * 1024)
+        log.clear();
+    ImGui::Begin("Log");
+    ImGui::TextUnformatted(log.c_str(), log.c_str() + log.size());
+    ImGui::End();
+
+    // Scratch data freed within the frame
+    {
+        QtImGui::Allocator::TransientScope transient;
+        ImGuiTextBuffer scratch;
+        for (int i = 0; i < 64 + frame % 512; i++)
+            scratch.appendf("%d,", i);
+        ImVector<ImVec2> points;
+        points.resize(256 + frame % 4096);
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QtImGui allocator soak test, prints JSON");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Frames to run", "count", "20000");
+    QCommandLineOption allocatorOption("allocator", "ImGui allocator: malloc, pool or arena", "policy", "arena");
+    QCommandLineOption sampleOption("sample", "Frames between samples of reserved memory", "count", "1000");
+    QCommandLineOption recreateOption("recreate", "Frames between recreations of the second renderer", "count", "500");
+    QCommandLineOption growthOption("max-growth", "Reserved memory growth allowed over the second half, in percent", "percent", "10");
+    parser.addOptions({ framesOption, allocatorOption, sampleOption, recreateOption, growthOption });
+    parser.process(app);
+
+    const int frames = std::max(2, parser.value(framesOption).toInt());
+    const int sample = std::max(1, parser.value(sampleOption).toInt());
+    const int recreate = std::max(1, parser.value(recreateOption).toInt());
+
+    QtImGui::InitOptions options;
+    options.backend = QtImGui::Backend::Software;
+    options.softwareThreads = 1;
+    options.trackAllocations = true;
+    if (parser.value(allocatorOption) == "pool")
+        options.allocator = QtImGui::AllocatorPolicy::Pool;
+    else if (parser.value(allocatorOption) == "arena")
+        options.allocator = QtImGui::AllocatorPolicy::FrameArena;
+
+    auto ref = QtImGui::initializeOffscreen(QSize(1024, 640), 1.0, options);
+    QtImGui::ImGuiRenderer *renderer = QtImGui::renderer(ref);
+    // Compacts the buffers of windows that stopped being drawn, like a long-running UI
+    ImGui::GetIO().ConfigMemoryCompactTimer = 1.0f;
+
+    QtImGui::RenderRef second = nullptr;
+    const int baseHeaps = QtImGui::Allocator::heapCount();
+    std::string log;
+    QJsonArray samples;
+    qint64 halfReserved = 0, peakReserved = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        QtImGui::newFrame(ref);
+        buildUi(frame, log);
+        ImGui::Render();
+        renderer->render();
+
+        if (frame % recreate == 0) {
+            if (second)
+                delete QtImGui::renderer(second);
+            second = QtImGui::initializeOffscreen(QSize(320, 240), 1.0, options);
+        }
+        QtImGui::newFrame(second);
+        ImGui::Begin("Second");
+        ImGui::Text("frame %d", frame);
+        ImGui::End();
+        ImGui::Render();
+        QtImGui::renderer(second)->render();
+
+        const qint64 reserved = renderer->allocatorStats().reservedBytes;
+        peakReserved = std::max(peakReserved, reserved);
+        if (frame == frames / 2)
+            halfReserved = reserved;
+        if (frame % sample == 0)
+            samples.append(QJsonObject{ { "frame", frame }, { "reserved_bytes", double(reserved) } });
+    }
+    delete QtImGui::renderer(second);
+
+    const qint64 finalReserved = renderer->allocatorStats().reservedBytes;
+    const double growth = halfReserved > 0 ? 100.0 * double(finalReserved - halfReserved) / double(halfReserved) : 0.0;
+    const int leakedHeaps = QtImGui::Allocator::heapCount() - baseHeaps;
+    const QJsonObject result{
+        { "allocator", parser.value(allocatorOption) },
+        { "frames", frames },
+        { "reserved_bytes_half", double(halfReserved) },
+        { "reserved_bytes_final", double(finalReserved) },
+        { "reserved_bytes_peak", double(peakReserved) },
+        { "growth_percent", growth },
+        { "leaked_heaps", leakedHeaps },
+        { "samples", samples },
+    };
+    std::printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Indented).constData());
+    return (growth > parser.value(growthOption).toDouble() || leakedHeaps > 0) ? 2 : 0;
+}
@@ -0,0 +1,239 @@
+// Synthetic scaling benchmark: builds parameterized UIs offscreen and prints JSON results.
+//
+//   qtimgui_bench --windows 10 --widgets 100 --series 4 --points 1000 --content text
+//
+// Runs without a display with QT_QPA_PLATFORM=offscreen, on Mesa (llvmpipe) or the
+// software backend (--backend software).
+
+#include <QtImGui.h>
+#include <ImGuiRenderer.h>
+#include <imgui.h>
+#include <implot.h>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Params {
+    int windows = 4;
+    int widgets = 50;
+    int series = 0;
+    int points = 1000;
+    bool textHeavy = true;
+};
+
+// Peak resident set size of the process, in KiB (0 where unsupported)
+qint64 peakMemoryKiB()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MACOS
+        return qint64(usage.ru_maxrss) / 1024;   // bytes on macOS
+#else
+        return qint64(usage.ru_maxrss);
+#endif
+    }
+#endif
+    return 0;
+}
+
+void buildUi(const Params &params, int frame, const std::vector<float> &xs, std::vector<float> &ys)
+{
+    const ImVec2 display = ImGui::GetIO().DisplaySize;
+    const int columns = std::max(1, int(std::ceil(std::sqrt(double(params.windows)))));
+    const ImVec2 size(display.x / columns, display.y / ((params.windows + columns - 1) / columns));
+
+    for (int w = 0; w < params.windows; w++) {
+        char title[32];
+        std::snprintf(title, sizeof(title), "Window %d", w);
+        ImGui::SetNextWindowPos(ImVec2((w % columns) * size.x, (w / columns) * size.y), ImGuiCond_Always);
+        ImGui::SetNextWindowSize(size, ImGuiCond_Always);
+        ImGui::Begin(title);
+
+        if (params.textHeavy) {
+            for (int i = 0; i < params.widgets; i++)
+                ImGui::Text("Item %d: value %.3f, frame %d", i, std::sin(0.01f * (i + frame)), frame);
+        } else {
+            ImDrawList *draw = ImGui::GetWindowDrawList();
+            const ImVec2 origin = ImGui::GetCursorScreenPos();
+            for (int i = 0; i < params.widgets; i++) {
+                const float x = origin.x + float((i * 37 + frame) % int(std::max(1.0f, size.x - 20)));
+                const float y = origin.y + float((i * 53) % int(std::max(1.0f, size.y - 40)));
+                const ImU32 color = IM_COL32(50 + (i * 13) % 200, 80 + (i * 7) % 170, 200, 200);
+                switch (i % 3) {
+                case 0: draw->AddRectFilled(ImVec2(x, y), ImVec2(x + 12, y + 8), color, 2.0f); break;
+                case 1: draw->AddCircleFilled(ImVec2(x, y), 5.0f, color); break;
+                default: draw->AddLine(ImVec2(x, y), ImVec2(x + 15, y + 10), color, 1.5f); break;
+                }
+            }
+        }
+
+        if (params.series > 0 && ImPlot::BeginPlot("##plot", ImVec2(-1, 150))) {
+            for (int s = 0; s < params.series; s++) {
+                for (int i = 0; i < params.points; i++)
+                    ys[size_t(i)] = std::sin(xs[size_t(i)] * (s + 1) + 0.05f * frame);
+                char label[16];
+                std::snprintf(label, sizeof(label), "s%d", s);
+                ImPlot::PlotLine(label, xs.data(), ys.data(), params.points);
+            }
+            ImPlot::EndPlot();
+        }
+        ImGui::End();
+    }
+}
+
+QJsonObject summarize(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    double sum = 0;
+    for (double v : values)
+        sum += v;
+    auto at = [&values](double p) { return values[std::min(values.size() - 1, size_t(p * values.size()))]; };
+    return QJsonObject{
+        { "mean", values.empty() ? 0.0 : sum / values.size() },
+        { "p50", values.empty() ? 0.0 : at(0.5) },
+        { "p95", values.empty() ? 0.0 : at(0.95) },
+        { "max", values.empty() ? 0.0 : values.back() },
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("QtImGui synthetic scaling benchmark, prints JSON");
+    parser.addHelpOption();
+    QCommandLineOption windowsOption("windows", "ImGui windows", "N", "4");
+    QCommandLineOption widgetsOption("widgets", "Widgets (text lines or shapes) per window", "M", "50");
+    QCommandLineOption seriesOption("series", "ImPlot line series per window", "K", "0");
+    QCommandLineOption pointsOption("points", "Points per series", "P", "1000");
+    QCommandLineOption contentOption("content", "text or shapes", "kind", "text");
+    QCommandLineOption framesOption("frames", "Measured frames", "count", "300");
+    QCommandLineOption warmupOption("warmup", "Frames run before measuring", "count", "30");
+    QCommandLineOption sizeOption("size", "Display size, WxH", "size", "1920x1080");
+    QCommandLineOption backendOption("backend", "opengl or software", "backend", "opengl");
+    QCommandLineOption allocatorOption("allocator", "ImGui allocator: malloc, pool or arena", "policy", "malloc");
+    parser.addOptions({ windowsOption, widgetsOption, seriesOption, pointsOption, contentOption,
+                        framesOption, warmupOption, sizeOption, backendOption, allocatorOption });
+    parser.process(app);
+
+    Params params;
+    params.windows = std::max(1, parser.value(windowsOption).toInt());
+    params.widgets = std::max(0, parser.value(widgetsOption).toInt());
+    params.series = std::max(0, parser.value(seriesOption).toInt());
+    params.points = std::max(1, parser.value(pointsOption).toInt());
+    params.textHeavy = parser.value(contentOption) != "shapes";
+    const int frames = std::max(1, parser.value(framesOption).toInt());
+    const int warmup = std::max(0, parser.value(warmupOption).toInt());
+    const QStringList size = parser.value(sizeOption).split('x');
+    const QSize displaySize(size.value(0).toInt(), size.value(1).toInt());
+    if (displaySize.isEmpty())
+        parser.showHelp(1);
+
+    QtImGui::InitOptions options;
+    options.trackAllocations = true;
+    const bool software = parser.value(backendOption) == "software";
+    if (software)
+        options.backend = QtImGui::Backend::Software;
+    if (parser.value(allocatorOption) == "pool")
+        options.allocator = QtImGui::AllocatorPolicy::Pool;
+    else if (parser.value(allocatorOption) == "arena")
+        options.allocator = QtImGui::AllocatorPolicy::FrameArena;
+    auto ref = QtImGui::initializeOffscreen(displaySize, 1.0, options);
+    QtImGui::ImGuiRenderer *renderer = QtImGui::renderer(ref);
+    renderer->setGpuTiming(!software);
+    ImPlot::CreateContext();
+
+    std::vector<float> xs(size_t(params.points)), ys(size_t(params.points));
+    for (int i = 0; i < params.points; i++)
+        xs[size_t(i)] = i * 0.01f;
+
+    std::vector<double> newFrameMs, buildMs, renderMs, gpuMs;
+    qint64 drawCalls = 0, bytesUploaded = 0, vertices = 0, glCalls = 0, glQueries = 0;
+    quint64 imguiAllocations = 0;
+    QElapsedTimer timer;
+
+    for (int frame = 0; frame < warmup + frames; frame++) {
+        timer.start();
+        QtImGui::newFrame(ref);
+        const double tNewFrame = timer.nsecsElapsed() / 1e6;
+
+        timer.start();
+        buildUi(params, frame, xs, ys);
+        ImGui::Render();
+        const double tBuild = timer.nsecsElapsed() / 1e6;
+
+        ImDrawData *drawData = ImGui::GetDrawData();
+        timer.start();
+        renderer->render(drawData);
+        const double tRender = timer.nsecsElapsed() / 1e6;
+
+        if (frame < warmup)
+            continue;
+        newFrameMs.push_back(tNewFrame);
+        buildMs.push_back(tBuild);
+        renderMs.push_back(tRender);
+        for (int n = 0; n < drawData->CmdListsCount; n++) {
+            const ImDrawList *list = drawData->CmdLists[n];
+            bytesUploaded += qint64(list->VtxBuffer.Size) * sizeof(ImDrawVert)
+                           + qint64(list->IdxBuffer.Size) * sizeof(ImDrawIdx);
+            for (const ImDrawCmd &cmd : list->CmdBuffer)
+                drawCalls += (!cmd.UserCallback && cmd.ElemCount > 0) ? 1 : 0;
+        }
+        vertices += drawData->TotalVtxCount;
+        imguiAllocations += renderer->frameAllocations().allocations;
+        if (!software) {
+            const QtImGui::FrameStats stats = renderer->frameStats();
+            glCalls += stats.drawCalls + stats.binds + stats.stateChanges + stats.queries + stats.bufferOrphans;
+            glQueries += stats.queries;
+            if (stats.gpuMs >= 0)
+                gpuMs.push_back(stats.gpuMs);
+        }
+    }
+
+    ImPlot::DestroyContext();
+
+    const QJsonObject result{
+        { "params", QJsonObject{
+            { "windows", params.windows },
+            { "widgets", params.widgets },
+            { "series", params.series },
+            { "points", params.points },
+            { "content", params.textHeavy ? "text" : "shapes" },
+            { "frames", frames },
+            { "width", displaySize.width() },
+            { "height", displaySize.height() },
+            { "backend", software ? "software" : "opengl" },
+            { "allocator", parser.value(allocatorOption) },
+        } },
+        { "newFrame_ms", summarize(newFrameMs) },
+        { "build_ms", summarize(buildMs) },
+        { "render_ms", summarize(renderMs) },
+        { "gpu_ms", summarize(gpuMs) },
+        { "draw_calls_per_frame", double(drawCalls) / frames },
+        { "vertices_per_frame", double(vertices) / frames },
+        { "gl_calls_per_frame", double(glCalls) / frames },
+        { "gl_queries_per_frame", double(glQueries) / frames },
+        { "bytes_uploaded_per_frame", double(bytesUploaded) / frames },
+        { "imgui_allocations_per_frame", double(imguiAllocations) / frames },
+        { "imgui_heap_reserved_bytes", double(renderer->allocatorStats().reservedBytes) },
+        { "peak_memory_kib", peakMemoryKiB() },
+    };
+    std::printf("%s\n", QJsonDocument(result).toJson(QJsonDocument::Indented).constData());
+    return 0;
+}
@@ -0,0 +1,329 @@
+// Replays an ImDrawData recording (ImGuiRenderer::startDrawDataRecording()) through the
+// renderer against an offscreen context and reports per-frame costs.
+//
+//   qtimgui_replay_bench [--frames N] [--csv] [--software] recording.qidr
+//   qtimgui_replay_bench --compare [--frames N] [--max-error E] recording.qidr
+//
+// --compare renders each frame through both the OpenGL and the software offscreen
+// renderers, and reports the per-pixel difference of their images and the time each
+// took to produce them.
+//
+// Runs without a display with QT_QPA_PLATFORM=offscreen.
+
+#include <QtImGui.h>
+#include <ImGuiRenderer.h>
+#include <DrawDataRecording.h>
+#include <imgui.h>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QOpenGLTexture>
+#include <QOpenGLTimerQuery>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+namespace {
+
+struct FrameResult {
+    double cpuMs = 0;
+    double gpuMs = -1;          // -1 without timer queries
+    int drawCalls = 0;
+    int bufferUploads = 0;      // glBufferData calls
+    int bufferReallocations = 0;
+    int binds = 0;
+    int stateChanges = 0;
+    int queries = 0;
+    qint64 bytesUploaded = 0;
+};
+
+double percentile(std::vector<double> values, double p)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, size_t(p * values.size()))];
+}
+
+void printSummary(const char *name, const std::vector<double> &values)
+{
+    if (values.empty())
+        return;
+    double sum = 0;
+    for (double v : values)
+        sum += v;
+    std::printf("%-8s mean %8.3f  p50 %8.3f  p95 %8.3f  max %8.3f ms\n", name, sum / values.size(),
+                percentile(values, 0.5), percentile(values, 0.95), percentile(values, 1.0));
+}
+
+ImDrawData *nextFrame(QtImGui::DrawDataReader &reader)
+{
+    ImDrawData *drawData = reader.readFrame();
+    if (!drawData) {
+        reader.rewind();
+        drawData = reader.readFrame();
+    }
+    return drawData;
+}
+
+// One empty frame creates the device objects, with the offscreen context current
+QtImGui::ImGuiRenderer *createRenderer(const QtImGui::InitOptions &options)
+{
+    auto ref = QtImGui::initializeOffscreen(QSize(1, 1), 1.0, options);
+    QtImGui::ImGuiRenderer *renderer = QtImGui::renderer(ref);
+    renderer->setFixedDeltaTime(1.0f / 60.0f);
+    QtImGui::newFrame(ref);
+    ImGui::Render();
+    renderer->render();
+    return renderer;
+}
+
+// Largest difference of the R, G and B channels of each pixel
+struct ImageError {
+    int max = 0;
+    double sum = 0;
+    qint64 pixels = 0;
+    qint64 differing = 0;   // Pixels above the tolerance of compareImages()
+};
+
+void compareImages(const QImage &a, const QImage &b, ImageError &error)
+{
+    // Tells rounding apart from real differences (missing or misplaced primitives)
+    const int tolerance = 2;
+    const QImage x = a.convertToFormat(QImage::Format_RGB32);
+    const QImage y = b.convertToFormat(QImage::Format_RGB32);
+    for (int row = 0; row < x.height(); row++) {
+        const QRgb *p = reinterpret_cast<const QRgb*>(x.constScanLine(row));
+        const QRgb *q = reinterpret_cast<const QRgb*>(y.constScanLine(row));
+        for (int col = 0; col < x.width(); col++) {
+            const int d = std::max({ std::abs(qRed(p[col]) - qRed(q[col])),
+                                     std::abs(qGreen(p[col]) - qGreen(q[col])),
+                                     std::abs(qBlue(p[col]) - qBlue(q[col])) });
+            error.max = std::max(error.max, d);
+            error.sum += d;
+            error.differing += d > tolerance ? 1 : 0;
+        }
+    }
+    error.pixels += qint64(x.width()) * x.height();
+}
+
+int compareBackends(const QString &path, int frames, int maxError)
+{
+    // Each renderer remaps the texture ids of its own copy of the frames
+    QtImGui::DrawDataReader glReader, softwareReader;
+    if (!glReader.open(path) || !softwareReader.open(path))
+        return 1;
+
+    QtImGui::ImGuiRenderer *gl = createRenderer(QtImGui::InitOptions());
+    const char *glRenderer = reinterpret_cast<const char*>(QOpenGLContext::currentContext()->functions()->glGetString(GL_RENDERER));
+    std::printf("OpenGL renderer: %s\n", glRenderer ? glRenderer : "unknown");
+    QOpenGLTexture glAtlas(glReader.fontAtlas(), QOpenGLTexture::DontGenerateMipMaps);
+    glAtlas.setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+    const ImTextureID glAtlasId = (ImTextureID)(size_t)glAtlas.textureId();
+
+    QtImGui::InitOptions softwareOptions;
+    softwareOptions.backend = QtImGui::Backend::Software;
+    QtImGui::ImGuiRenderer *software = createRenderer(softwareOptions);
+    QImage softwareAtlas = softwareReader.fontAtlas();
+    const ImTextureID softwareAtlasId = (ImTextureID)&softwareAtlas;
+
+    std::vector<double> glMs, softwareMs;
+    ImageError error;
+    int sizeMismatches = 0;
+    for (int i = 0; i < frames; i++) {
+        ImDrawData *glFrame = nextFrame(glReader);
+        ImDrawData *softwareFrame = nextFrame(softwareReader);
+        if (!glFrame || !softwareFrame)
+            return 1;
+        glReader.remapTextures(glAtlasId, glAtlasId);
+        softwareReader.remapTextures(softwareAtlasId, softwareAtlasId);
+
+        // Time to an image in memory: the OpenGL one includes the GPU work and the readback
+        QElapsedTimer timer;
+        timer.start();
+        const QImage glImage = gl->renderToImage(glFrame);
+        glMs.push_back(timer.nsecsElapsed() / 1e6);
+        timer.restart();
+        const QImage softwareImage = software->renderToImage(softwareFrame);
+        softwareMs.push_back(timer.nsecsElapsed() / 1e6);
+
+        if (glImage.size() != softwareImage.size()) {
+            sizeMismatches++;
+            continue;
+        }
+        compareImages(glImage, softwareImage, error);
+    }
+
+    std::printf("%d frames compared, OpenGL vs software\n", frames);
+    if (sizeMismatches > 0)
+        std::printf("%d frames skipped, image sizes differ\n", sizeMismatches);
+    std::printf("error    max %d  mean %.4f (0-255, per pixel)  %.3f%% of pixels above 2\n", error.max,
+                error.pixels > 0 ? error.sum / error.pixels : 0.0,
+                error.pixels > 0 ? 100.0 * error.differing / error.pixels : 0.0);
+    printSummary("opengl", glMs);
+    printSummary("software", softwareMs);
+    double glTotal = 0, softwareTotal = 0;
+    for (size_t i = 0; i < glMs.size(); i++) {
+        glTotal += glMs[i];
+        softwareTotal += softwareMs[i];
+    }
+    std::printf("time ratio opengl / software %.2f\n", softwareTotal > 0 ? glTotal / softwareTotal : 0.0);
+
+    if (sizeMismatches > 0 || (maxError >= 0 && error.max > maxError))
+        return 2;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a QtImGui draw data recording offscreen");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recording", "Recording written by ImGuiRenderer::startDrawDataRecording()");
+    QCommandLineOption framesOption("frames", "Frames to replay, looping over the recording (default: its length)", "count", "0");
+    QCommandLineOption csvOption("csv", "Print one CSV line per frame");
+    QCommandLineOption softwareOption("software", "Replay through the software rasterizer instead of OpenGL");
+    QCommandLineOption compareOption("compare", "Render through both OpenGL and the software rasterizer, report image error and time ratio");
+    QCommandLineOption maxErrorOption("max-error", "With --compare, exit with 2 when a pixel differs by more than this (default: no check)", "value", "-1");
+    parser.addOptions({ framesOption, csvOption, softwareOption, compareOption, maxErrorOption });
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(1);
+
+    QtImGui::DrawDataReader reader;
+    if (!reader.open(parser.positionalArguments().first()))
+        return 1;
+
+    ImDrawData *first = reader.readFrame();
+    if (!first) {
+        std::fprintf(stderr, "empty recording\n");
+        return 1;
+    }
+    int recordedFrames = 1;
+    while (reader.readFrame())
+        recordedFrames++;
+    reader.rewind();
+
+    const int frames = parser.value(framesOption).toInt() > 0 ? parser.value(framesOption).toInt() : recordedFrames;
+    if (parser.isSet(compareOption))
+        return compareBackends(parser.positionalArguments().first(), frames, parser.value(maxErrorOption).toInt());
+
+    QtImGui::InitOptions options;
+    if (parser.isSet(softwareOption))
+        options.backend = QtImGui::Backend::Software;
+    auto ref = QtImGui::initializeOffscreen(QSize(1, 1), 1.0, options);
+    QtImGui::ImGuiRenderer *renderer = QtImGui::renderer(ref);
+    // Replayed frames do not run ImGui; fixed anyway so that any UI built here is deterministic
+    renderer->setFixedDeltaTime(1.0f / 60.0f);
+
+    // One empty frame creates the device objects with the offscreen context current
+    QtImGui::newFrame(ref);
+    ImGui::Render();
+    renderer->render();
+
+    // Glyph UVs refer to the recorded atlas, upload it in place of the live one
+    std::unique_ptr<QOpenGLTexture> atlasTexture;
+    QImage softwareAtlas;
+    ImTextureID atlasId = nullptr;
+    if (parser.isSet(softwareOption)) {
+        softwareAtlas = reader.fontAtlas();
+        atlasId = (ImTextureID)&softwareAtlas;
+    } else {
+        atlasTexture.reset(new QOpenGLTexture(reader.fontAtlas(), QOpenGLTexture::DontGenerateMipMaps));
+        atlasTexture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+        atlasId = (ImTextureID)(size_t)atlasTexture->textureId();
+    }
+
+    QOpenGLTimerQuery timer;
+    const bool gpuTiming = !parser.isSet(softwareOption) && timer.create();
+
+    std::vector<FrameResult> results;
+    results.reserve(size_t(frames));
+    qint64 vtxCapacity = 0, idxCapacity = 0;
+    for (int i = 0; i < frames; i++) {
+        ImDrawData *drawData = reader.readFrame();
+        if (!drawData) {
+            reader.rewind();
+            drawData = reader.readFrame();
+        }
+        reader.remapTextures(atlasId, atlasId);
+
+        // The estimate follows the renderer: both shared buffers are orphaned once per pass
+        // and only reallocated when they grow (trimming is not modelled)
+        FrameResult result;
+        qint64 vtxBytes = 0, idxBytes = 0;
+        result.bufferUploads = 2;
+        for (int n = 0; n < drawData->CmdListsCount; n++) {
+            const ImDrawList *list = drawData->CmdLists[n];
+            vtxBytes += qint64(list->VtxBuffer.Size) * sizeof(ImDrawVert);
+            idxBytes += qint64(list->IdxBuffer.Size) * sizeof(ImDrawIdx);
+            for (const ImDrawCmd &cmd : list->CmdBuffer)
+                result.drawCalls += (!cmd.UserCallback && cmd.ElemCount > 0) ? 1 : 0;
+        }
+        result.bytesUploaded = vtxBytes + idxBytes;
+        result.bufferReallocations = (vtxBytes > vtxCapacity ? 1 : 0) + (idxBytes > idxCapacity ? 1 : 0);
+        vtxCapacity = qMax(vtxCapacity, vtxBytes);
+        idxCapacity = qMax(idxCapacity, idxBytes);
+
+        if (gpuTiming)
+            timer.begin();
+        QElapsedTimer cpu;
+        cpu.start();
+        renderer->render(drawData);
+        result.cpuMs = cpu.nsecsElapsed() / 1e6;
+        if (gpuTiming) {
+            timer.end();
+            result.gpuMs = timer.waitForResult() / 1e6;
+        }
+
+        // The OpenGL renderer counts its real GL calls, replacing the draw data estimates
+        if (!parser.isSet(softwareOption)) {
+            const QtImGui::FrameStats stats = renderer->frameStats();
+            result.drawCalls = stats.drawCalls;
+            result.bufferUploads = stats.bufferOrphans;
+            result.bufferReallocations = stats.bufferReallocations;
+            result.binds = stats.binds;
+            result.stateChanges = stats.stateChanges;
+            result.queries = stats.queries;
+            result.bytesUploaded = stats.bytesUploaded;
+        }
+        results.push_back(result);
+    }
+
+    if (parser.isSet(csvOption)) {
+        std::printf("frame,cpu_ms,gpu_ms,draw_calls,buffer_uploads,buffer_reallocations,binds,state_changes,queries,"
+                    "bytes_uploaded\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const FrameResult &r = results[i];
+            std::printf("%zu,%.4f,%.4f,%d,%d,%d,%d,%d,%d,%lld\n", i, r.cpuMs, r.gpuMs, r.drawCalls, r.bufferUploads,
+                        r.bufferReallocations, r.binds, r.stateChanges, r.queries, (long long)r.bytesUploaded);
+        }
+    }
+
+    std::vector<double> cpu, gpu;
+    qint64 drawCalls = 0, bytes = 0, calls = 0;
+    for (const FrameResult &r : results) {
+        cpu.push_back(r.cpuMs);
+        if (r.gpuMs >= 0)
+            gpu.push_back(r.gpuMs);
+        drawCalls += r.drawCalls;
+        bytes += r.bytesUploaded;
+        calls += r.drawCalls + r.bufferUploads + r.binds + r.stateChanges + r.queries;
+    }
+    std::printf("%d frames (%d recorded), %s\n", frames, recordedFrames,
+                parser.isSet(softwareOption) ? "software" : "OpenGL");
+    printSummary("cpu", cpu);
+    printSummary("gpu", gpu);
+    std::printf("per frame: %.1f draw calls, %.1f GL calls, %.1f KiB uploaded\n",
+                double(drawCalls) / frames, double(calls) / frames, double(bytes) / frames / 1024.0);
+    return 0;
+}
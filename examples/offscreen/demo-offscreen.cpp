@@ -0,0 +1,51 @@
+#include <QtImGui.h>
+#include <imgui.h>
+#include <implot.h>
+#include <QGuiApplication>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QSize>
+#include <cmath>
+
+// Renders a few report images without any window, e.g. with -platform offscreen.
+// Pass "software" to rasterize on the CPU instead of an offscreen GL context.
+int main(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+
+    QtImGui::InitOptions options;
+    if (a.arguments().contains("software"))
+        options.backend = QtImGui::Backend::Software;
+
+    const QSize size(640, 360);
+    auto ref = QtImGui::initializeOffscreen(size, 2.0, options);
+    ImPlot::CreateContext();
+
+    float xs[200], ys[200];
+    QElapsedTimer timer;
+    timer.start();
+    for (int image = 0; image < 10; image++) {
+        for (int i = 0; i < 200; i++) {
+            xs[i] = i * 0.05f;
+            ys[i] = std::sin(xs[i] * (image + 1));
+        }
+
+        QtImGui::newFrame(ref);
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(ImVec2(float(size.width()), float(size.height())));
+        ImGui::Begin("Report", nullptr, ImGuiWindowFlags_NoDecoration);
+        ImGui::Text("Report %d", image);
+        if (ImPlot::BeginPlot("sin")) {
+            ImPlot::PlotLine("y", xs, ys, 200);
+            ImPlot::EndPlot();
+        }
+        ImGui::End();
+        ImGui::Render();
+
+        QtImGui::renderToImage(ref).save(QString("report-%1.png").arg(image));
+    }
+    qInfo("10 images in %lld ms", timer.elapsed());
+
+    ImPlot::DestroyContext();
+    return 0;
+}
@@ -0,0 +1,8 @@
+QT       += core gui
+TARGET = demo-offscreen
+TEMPLATE = app
+
+include(../../qtimgui.pri)
+
+SOURCES += \
+    demo-offscreen.cpp
@@ -0,0 +1,67 @@
+#include <QtImGui.h>
+#include <imgui.h>
+#include <QApplication>
+#include <QGridLayout>
+#include <QTimer>
+#include <QWidget>
+
+// A plain QWidget hosting ImGui through the QPainter backend: no GL context, no FBO
+class Panel : public QWidget
+{
+public:
+    explicit Panel(int index, QWidget *parent = nullptr)
+        : QWidget(parent), index(index)
+    {
+        QtImGui::InitOptions options;
+        options.backend = QtImGui::Backend::Painter;
+        ref = QtImGui::initialize(this, options, false);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *) override
+    {
+        QtImGui::newFrame(ref);
+
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin("Panel", nullptr, ImGuiWindowFlags_NoDecoration);
+        ImGui::Text("Panel %d", index);
+        ImGui::SliderFloat("value", &value, 0.0f, 1.0f);
+        ImGui::ProgressBar(value);
+        ImGui::End();
+
+        ImGui::Render();
+        QtImGui::render(ref);
+    }
+
+private:
+    QtImGui::RenderRef ref = nullptr;
+    int index;
+    float value = 0.5f;
+};
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    QWidget w;
+    auto *layout = new QGridLayout(&w);
+    for (int i = 0; i < 16; i++) {
+        auto *panel = new Panel(i, &w);
+        panel->setMinimumSize(200, 90);
+        layout->addWidget(panel, i / 4, i % 4);
+    }
+    w.setWindowTitle("QtImGui QPainter example");
+    w.show();
+
+    // Update at 60 fps
+    QTimer timer;
+    QObject::connect(&timer, &QTimer::timeout, [&w]() {
+        const auto panels = w.findChildren<QWidget*>();
+        for (QWidget *panel : panels)
+            panel->update();
+    });
+    timer.start(16);
+
+    return a.exec();
+}
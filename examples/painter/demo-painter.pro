@@ -0,0 +1,8 @@
+QT       += core gui widgets
+TARGET = demo-painter
+TEMPLATE = app
+
+include(../../qtimgui.pri)
+
+SOURCES += \
+    demo-painter.cpp
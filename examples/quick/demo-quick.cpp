@@ -0,0 +1,77 @@
+#include <QtImGui.h>
+#include <ImGuiQuickItem.h>
+#include <imgui.h>
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QSurfaceFormat>
+#include <QOpenGLContext>
+
+// The UI is built on the GUI thread, Qt Quick's render thread draws it in the scene graph
+class DemoItem : public QtImGui::ImGuiQuickItem
+{
+    Q_OBJECT
+protected:
+    void paintImGui() override
+    {
+        static float f = 0.0f;
+        ImGui::Text("Hello from Qt Quick!");
+        ImGui::SliderFloat("float", &f, 0.0f, 1.0f);
+        if (ImGui::Button("Test Window")) show_test_window ^= 1;
+        ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+
+        if (show_test_window)
+            ImGui::ShowDemoWindow(&show_test_window);
+    }
+
+private:
+    bool show_test_window = true;
+};
+
+static const char *qml = R"(
+import QtQuick 2.12
+import QtQuick.Window 2.12
+import QtImGui 1.0
+
+Window {
+    width: 1280
+    height: 720
+    visible: true
+    title: "QtImGui Qt Quick item example"
+    color: "#72909a"
+
+    Rectangle {
+        anchors.fill: parent
+        anchors.margins: 40
+        color: "transparent"
+        border.color: "white"
+
+        DemoItem {
+            anchors.fill: parent
+            anchors.margins: 1
+        }
+    }
+}
+)";
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+
+    // Use OpenGL 3 Core Profile, when available
+    QSurfaceFormat glFormat;
+    if (QOpenGLContext::openGLModuleType() == QOpenGLContext::LibGL)
+    {
+        glFormat.setVersion(3, 3);
+        glFormat.setProfile(QSurfaceFormat::CoreProfile);
+    }
+    QSurfaceFormat::setDefaultFormat(glFormat);
+
+    qmlRegisterType<DemoItem>("QtImGui", 1, 0, "DemoItem");
+
+    QQmlApplicationEngine engine;
+    engine.loadData(qml);
+
+    return a.exec();
+}
+
+#include "demo-quick.moc"
@@ -0,0 +1,8 @@
+QT       += core gui qml quick
+TARGET = demo-quick
+TEMPLATE = app
+
+include(../../qtimgui.pri)
+
+SOURCES += \
+    demo-quick.cpp
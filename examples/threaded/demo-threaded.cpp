@@ -0,0 +1,85 @@
+#include <QtImGui.h>
+#include <ImGuiRenderer.h>
+#include <imgui.h>
+#include <QGuiApplication>
+#include <QTimer>
+#include <QSurfaceFormat>
+#include <QOpenGLContext>
+#include <QWindow>
+
+// ImGui frames are built on the GUI thread and drawn by a render thread owning the
+// window's GL context. The window is a plain QWindow: all drawing goes through QtImGui.
+class DemoWindow : public QWindow
+{
+public:
+    DemoWindow()
+    {
+        setSurfaceType(QSurface::OpenGLSurface);
+    }
+
+    void start()
+    {
+        QtImGui::InitOptions options;
+        options.threadedRendering = true;
+        ref = QtImGui::initialize(this, options, false);
+    }
+
+    void frame()
+    {
+        QtImGui::newFrame(ref);
+
+        {
+            static float f = 0.0f;
+            ImGui::Text("Hello, world!");
+            ImGui::SliderFloat("float", &f, 0.0f, 1.0f);
+            ImGui::ColorEdit3("clear color", (float*)&clear_color);
+            if (ImGui::Button("Test Window")) show_test_window ^= 1;
+            ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        }
+
+        if (show_test_window)
+        {
+            ImGui::SetNextWindowPos(ImVec2(650, 20), ImGuiCond_FirstUseEver);
+            ImGui::ShowDemoWindow(&show_test_window);
+        }
+
+        // No GL on this thread: the render thread clears the window before drawing ImGui
+        QtImGui::renderer(ref)->setClearColor(clear_color);
+
+        ImGui::Render();
+        QtImGui::render(ref);
+    }
+
+private:
+    QtImGui::RenderRef ref = nullptr;
+    bool show_test_window = true;
+    ImVec4 clear_color = ImColor(114, 144, 154);
+};
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+
+    // Use OpenGL 3 Core Profile, when available
+    QSurfaceFormat glFormat;
+    if (QOpenGLContext::openGLModuleType() == QOpenGLContext::LibGL)
+    {
+        glFormat.setVersion(3, 3);
+        glFormat.setProfile(QSurfaceFormat::CoreProfile);
+    }
+    QSurfaceFormat::setDefaultFormat(glFormat);
+
+    // Show window
+    DemoWindow w;
+    w.setTitle("QtImGui threaded rendering example");
+    w.resize(1280, 720);
+    w.show();
+    w.start();
+
+    // Build a frame at 60 fps, submission happens on the render thread
+    QTimer timer;
+    QObject::connect(&timer, &QTimer::timeout, [&w]() { w.frame(); });
+    timer.start(16);
+
+    return a.exec();
+}
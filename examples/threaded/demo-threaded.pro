@@ -0,0 +1,8 @@
+QT       += core gui
+TARGET = demo-threaded
+TEMPLATE = app
+
+include(../../qtimgui.pri)
+
+SOURCES += \
+    demo-threaded.cpp
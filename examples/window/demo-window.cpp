@@ -1,4 +1,5 @@
 #include <QtImGui.h>
+#include <ImGuiRenderer.h>
 #include <imgui.h>
 #include <QGuiApplication>
 #include <QTimer>
@@ -27,6 +28,11 @@ protected:
             ImGui::ColorEdit3("clear color", (float*)&clear_color);
             if (ImGui::Button("Test Window")) show_test_window ^= 1;
             if (ImGui::Button("Another Window")) show_another_window ^= 1;
+            if (ImGui::Button("Frame Timings")) show_frame_timings ^= 1;
+            if (ImGui::Button("Render Profiler")) {
+                show_render_profiler ^= 1;
+                QtImGui::renderer()->setWindowCostTracking(show_render_profiler);
+            }
             ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
         }
 
@@ -39,6 +45,14 @@ protected:
             ImGui::End();
         }
 
+        // Percentiles of newFrame(), UI building and render() over the last frames
+        if (show_frame_timings)
+            QtImGui::renderer()->frameTimings().drawWindow(&show_frame_timings);
+
+        // Vertices, uploads and draw commands of each window, refreshed every second
+        if (show_render_profiler)
+            QtImGui::renderer()->drawRenderProfiler(&show_render_profiler);
+
         // 3. Show the ImGui test window. Most of the sample code is in ImGui::ShowTestWindow()
         if (show_test_window)
         {
@@ -58,6 +72,8 @@ protected:
 private:
     bool show_test_window = true;
     bool show_another_window = false;
+    bool show_frame_timings = false;
+    bool show_render_profiler = false;
     ImVec4 clear_color = ImColor(114, 144, 154);
 };
 
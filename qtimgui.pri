@@ -13,9 +13,63 @@ INCLUDEPATH += \
     $$PWD/src
 
 HEADERS += \
+    $$PWD/src/BufferTrim.h \
+    $$PWD/src/CountingOpenGLFunctions.h \
+    $$PWD/src/DrawDataRecording.h \
+    $$PWD/src/DrawDataSnapshot.h \
+    $$PWD/src/FrameBudget.h \
+    $$PWD/src/FrameRecorder.h \
+    $$PWD/src/FrameStats.h \
+    $$PWD/src/FrameTimings.h \
+    $$PWD/src/GlDebug.h \
+    $$PWD/src/GlResources.h \
+    $$PWD/src/GpuTimer.h \
+    $$PWD/src/ImGuiAllocator.h \
     $$PWD/src/ImGuiRenderer.h \
-    $$PWD/src/QtImGui.h
+    $$PWD/src/MemoryStats.h \
+    $$PWD/src/MetricsExporter.h \
+    $$PWD/src/OffscreenTarget.h \
+    $$PWD/src/PainterRenderer.h \
+    $$PWD/src/QtImGui.h \
+    $$PWD/src/RenderBackend.h \
+    $$PWD/src/RenderThread.h \
+    $$PWD/src/SoftwareRasterizer.h \
+    $$PWD/src/Trace.h \
+    $$PWD/src/ViewportPool.h \
+    $$PWD/src/WindowCost.h
 
 SOURCES += \
+    $$PWD/src/BufferTrim.cpp \
+    $$PWD/src/DrawDataRecording.cpp \
+    $$PWD/src/DrawDataSnapshot.cpp \
+    $$PWD/src/FrameBudget.cpp \
+    $$PWD/src/FrameRecorder.cpp \
+    $$PWD/src/FrameTimings.cpp \
+    $$PWD/src/GlDebug.cpp \
+    $$PWD/src/GlResources.cpp \
+    $$PWD/src/GpuTimer.cpp \
+    $$PWD/src/ImGuiAllocator.cpp \
     $$PWD/src/ImGuiRenderer.cpp \
-    $$PWD/src/QtImGui.cpp
+    $$PWD/src/MetricsExporter.cpp \
+    $$PWD/src/OffscreenTarget.cpp \
+    $$PWD/src/PainterRenderer.cpp \
+    $$PWD/src/QtImGui.cpp \
+    $$PWD/src/RenderThread.cpp \
+    $$PWD/src/SoftwareRasterizer.cpp \
+    $$PWD/src/Trace.cpp \
+    $$PWD/src/ViewportPool.cpp \
+    $$PWD/src/WindowCost.cpp
+
+# MetricsExporter::listen() needs QT += network, metrics can be written to a file without it
+
+# QTIMGUI_ZONE() trace zones are compiled out unless CONFIG += qtimgui_trace
+qtimgui_trace: DEFINES += QTIMGUI_ENABLE_TRACE
+
+# GL call counters of ImGuiRenderer::frameStats() are left out with CONFIG += qtimgui_no_gl_counters
+qtimgui_no_gl_counters: DEFINES += QTIMGUI_NO_GL_COUNTERS
+
+# Qt Quick scene graph item, for apps using QT += quick
+contains(QT, quick) {
+    HEADERS += $$PWD/src/ImGuiQuickItem.h
+    SOURCES += $$PWD/src/ImGuiQuickItem.cpp
+}
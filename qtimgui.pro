@@ -1,3 +1,3 @@
 TEMPLATE = subdirs
 
-SUBDIRS += examples/widget examples/window
+SUBDIRS += examples/widget examples/window examples/threaded examples/quick examples/painter examples/offscreen
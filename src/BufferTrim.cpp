@@ -0,0 +1,111 @@
+#include "BufferTrim.h"
+
+#include <imgui.h>
+#include <imgui_internal.h>
+#include <cstring>
+
+namespace QtImGui {
+
+namespace {
+
+// Vectors below this are not worth a reallocation
+const qint64 kMinVectorBytes = 4 * 1024;
+
+template<typename T>
+void measure(const ImVector<T> &v, DrawListMemory &memory)
+{
+    memory.usedBytes += qint64(v.Size) * qint64(sizeof(T));
+    memory.capacityBytes += qint64(v.Capacity) * qint64(sizeof(T));
+}
+
+// Reallocates `v` to its content plus headroom when it holds more than shrinkFactor times
+// its content, keeping the content
+template<typename T>
+qint64 shrink(ImVector<T> &v, const TrimOptions &options)
+{
+    const qint64 capacityBytes = qint64(v.Capacity) * qint64(sizeof(T));
+    if (capacityBytes < kMinVectorBytes || qint64(v.Capacity) <= qint64(options.shrinkFactor) * v.Size)
+        return 0;
+
+    const int capacity = int(HighWaterMark::withHeadroom(v.Size));
+    if (capacity == 0) {
+        v.clear();  // Frees the buffer
+        return capacityBytes;
+    }
+    ImVector<T> fitted;
+    fitted.reserve(capacity);
+    fitted.resize(v.Size);
+    memcpy(fitted.Data, v.Data, size_t(v.Size) * sizeof(T));
+    v.swap(fitted);
+    return capacityBytes - qint64(capacity) * qint64(sizeof(T));
+}
+
+} // namespace
+
+qint64 HighWaterMark::update(qint64 used, qint64 capacity, const TrimOptions &options)
+{
+    m_highWater = qMax(m_highWater, used);
+    if (used > capacity) {
+        m_quietFrames = 0;
+        return withHeadroom(used);
+    }
+
+    const bool oversized = options.quietFrames > 0 && capacity >= options.minBytes
+                        && capacity > qint64(options.shrinkFactor) * used;
+    if (!oversized) {
+        m_quietFrames = 0;
+        return capacity;
+    }
+
+    m_quietPeak = m_quietFrames == 0 ? used : qMax(m_quietPeak, used);
+    if (++m_quietFrames < options.quietFrames)
+        return capacity;
+
+    m_quietFrames = 0;
+    return withHeadroom(m_quietPeak);
+}
+
+DrawListMemory drawListMemory(ImGuiContext *ctx)
+{
+    DrawListMemory memory;
+    if (!ctx)
+        return memory;
+    for (ImGuiWindow *window : ctx->Windows) {
+        const ImDrawList *list = window->DrawList;
+        measure(list->VtxBuffer, memory);
+        measure(list->IdxBuffer, memory);
+        measure(list->CmdBuffer, memory);
+        for (const ImDrawChannel &channel : list->_Splitter._Channels) {
+            measure(channel._CmdBuffer, memory);
+            measure(channel._IdxBuffer, memory);
+        }
+    }
+    return memory;
+}
+
+qint64 trimDrawLists(ImGuiContext *ctx, const TrimOptions &options)
+{
+    if (!ctx)
+        return 0;
+
+    qint64 released = 0;
+    for (ImGuiWindow *window : ctx->Windows) {
+        // Active still tells whether the window was drawn in the last frame
+        if (!window->Active)
+            continue;
+        ImDrawList *list = window->DrawList;
+        released += shrink(list->VtxBuffer, options);
+        released += shrink(list->IdxBuffer, options);
+        released += shrink(list->CmdBuffer, options);
+        for (ImDrawChannel &channel : list->_Splitter._Channels) {
+            released += shrink(channel._CmdBuffer, options);
+            released += shrink(channel._IdxBuffer, options);
+        }
+        // PrimReserve() sets them again, but not pointing into freed memory costs nothing
+        list->_VtxWritePtr = list->VtxBuffer.Data + list->VtxBuffer.Size;
+        list->_IdxWritePtr = list->IdxBuffer.Data + list->IdxBuffer.Size;
+    }
+    return released;
+}
+
+} // namespace QtImGui
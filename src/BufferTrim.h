@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QtGlobal>
+
+struct ImGuiContext;
+
+namespace QtImGui {
+
+struct TrimOptions {
+    int quietFrames = 300;          // Frames a buffer must stay oversized before it shrinks; 0 disables trimming
+    int shrinkFactor = 4;           // Oversized: capacity above shrinkFactor times the use of each of those frames
+    qint64 minBytes = 64 * 1024;    // Smaller buffers are never trimmed
+};
+
+// Buffer memory of a renderer and what trimming gave back, see ImGuiRenderer::trimStats()
+struct TrimStats {
+    qint64 gpuCapacityBytes = 0;    // VBO + IBO storage of the built-in OpenGL renderer
+    qint64 gpuHighWaterBytes = 0;   // Largest VBO + IBO use of a pass
+    qint64 cpuCapacityBytes = 0;    // Vertex, index and command buffers of the context's draw lists
+    qint64 cpuUsedBytes = 0;        // Part of them filled by the last frame
+    qint64 cpuHighWaterBytes = 0;   // Largest use of a frame
+    quint64 gpuTrims = 0;           // VBO or IBO shrinks
+    quint64 cpuTrims = 0;           // Draw list shrinks, each may cover several lists
+    qint64 gpuBytesReleased = 0;
+    qint64 cpuBytesReleased = 0;
+};
+
+// Decides the capacity of a buffer that grows with load spikes and shrinks after them.
+//
+// A buffer grows at once, with headroom, when a frame needs more than its capacity. It
+// only shrinks after quietFrames consecutive frames using less than 1/shrinkFactor of
+// it, and then to the peak of those frames plus the same headroom: the next shrink needs
+// another quiet period, and a buffer whose use oscillates is never resized.
+class HighWaterMark {
+public:
+    // Capacity for a frame using `used` bytes, given the current `capacity`. Below
+    // `capacity` when the buffer should be trimmed.
+    qint64 update(qint64 used, qint64 capacity, const TrimOptions &options);
+
+    // Largest use seen
+    qint64 highWater() const { return m_highWater; }
+
+    static qint64 withHeadroom(qint64 used) { return used + used / 2; }
+
+private:
+    qint64 m_highWater = 0;
+    qint64 m_quietPeak = 0;
+    int m_quietFrames = 0;
+};
+
+// Draw list buffers of a context: the window draw lists and their channel splitters
+struct DrawListMemory {
+    qint64 usedBytes = 0;
+    qint64 capacityBytes = 0;
+};
+
+DrawListMemory drawListMemory(ImGuiContext *ctx);
+
+// Shrinks the buffers of the draw lists of `ctx` holding more than shrinkFactor times
+// their content, to their content plus headroom. Must run between frames, before
+// ImGui::NewFrame(). Returns the bytes released.
+//
+// Draw lists of windows that stopped being drawn are left to ImGui's own garbage
+// collection (io.ConfigMemoryCompactTimer), like table splitters.
+qint64 trimDrawLists(ImGuiContext *ctx, const TrimOptions &options);
+
+} // namespace QtImGui
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+
+#include "FrameStats.h"
+
+namespace QtImGui {
+
+// QOpenGLExtraFunctions with the entry points used by the renderer shadowed by counting
+// wrappers. Classes inheriting it call the wrappers without any change to their code;
+// calls made through other QOpenGLFunctions instances are not counted.
+//
+// Built with QTIMGUI_NO_GL_COUNTERS (CMake option QTIMGUI_COUNT_GL_CALLS=OFF, CONFIG +=
+// qtimgui_no_gl_counters with qmake) the wrappers are left out and calls go straight to
+// QOpenGLExtraFunctions; FrameStats then only holds the pass timings and reallocations.
+class CountingOpenGLFunctions : public QOpenGLExtraFunctions {
+protected:
+    FrameStats m_glCounters;
+
+#ifndef QTIMGUI_NO_GL_COUNTERS
+    void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid *indices)
+    {
+        m_glCounters.drawCalls++;
+        QOpenGLExtraFunctions::glDrawElements(mode, count, type, indices);
+    }
+
+    // Bindings
+    void glUseProgram(GLuint program)
+    {
+        m_glCounters.binds++;
+        QOpenGLExtraFunctions::glUseProgram(program);
+    }
+    void glBindVertexArray(GLuint array)
+    {
+        m_glCounters.binds++;
+        QOpenGLExtraFunctions::glBindVertexArray(array);
+    }
+    void glBindBuffer(GLenum target, GLuint buffer)
+    {
+        m_glCounters.binds++;
+        QOpenGLExtraFunctions::glBindBuffer(target, buffer);
+    }
+    void glBindTexture(GLenum target, GLuint texture)
+    {
+        m_glCounters.binds++;
+        QOpenGLExtraFunctions::glBindTexture(target, texture);
+    }
+    void glBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        m_glCounters.binds++;
+        QOpenGLExtraFunctions::glBindFramebuffer(target, framebuffer);
+    }
+
+    // State changes
+    void glEnable(GLenum cap)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glEnable(cap);
+    }
+    void glDisable(GLenum cap)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glDisable(cap);
+    }
+    void glActiveTexture(GLenum texture)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glActiveTexture(texture);
+    }
+    void glBlendEquation(GLenum mode)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glBlendEquation(mode);
+    }
+    void glBlendEquationSeparate(GLenum modeRGB, GLenum modeAlpha)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glBlendEquationSeparate(modeRGB, modeAlpha);
+    }
+    void glBlendFunc(GLenum sfactor, GLenum dfactor)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glBlendFunc(sfactor, dfactor);
+    }
+    void glBlendFuncSeparate(GLenum srcRGB, GLenum dstRGB, GLenum srcAlpha, GLenum dstAlpha)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    }
+    void glScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glScissor(x, y, width, height);
+    }
+    void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glViewport(x, y, width, height);
+    }
+    void glUniform1i(GLint location, GLint x)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glUniform1i(location, x);
+    }
+    void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value)
+    {
+        m_glCounters.stateChanges++;
+        QOpenGLExtraFunctions::glUniformMatrix4fv(location, count, transpose, value);
+    }
+
+    // Queries
+    void glGetIntegerv(GLenum pname, GLint *params)
+    {
+        m_glCounters.queries++;
+        QOpenGLExtraFunctions::glGetIntegerv(pname, params);
+    }
+    GLboolean glIsEnabled(GLenum cap)
+    {
+        m_glCounters.queries++;
+        return QOpenGLExtraFunctions::glIsEnabled(cap);
+    }
+
+    // Uploads
+    void glBufferData(GLenum target, qopengl_GLsizeiptr size, const void *data, GLenum usage)
+    {
+        // Whether the size changed is only known to the caller, which counts reallocations
+        m_glCounters.bufferOrphans++;
+        m_glCounters.bytesUploaded += data ? qint64(size) : 0;
+        QOpenGLExtraFunctions::glBufferData(target, size, data, usage);
+    }
+    void glBufferSubData(GLenum target, qopengl_GLintptr offset, qopengl_GLsizeiptr size, const void *data)
+    {
+        m_glCounters.bytesUploaded += qint64(size);
+        QOpenGLExtraFunctions::glBufferSubData(target, offset, size, data);
+    }
+    void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                      GLint border, GLenum format, GLenum type, const GLvoid *pixels)
+    {
+        // The renderer only uploads RGBA8
+        m_glCounters.bytesUploaded += pixels ? qint64(width) * height * 4 : 0;
+        QOpenGLExtraFunctions::glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+    }
+#endif
+};
+
+} // namespace QtImGui
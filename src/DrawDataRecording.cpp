@@ -0,0 +1,327 @@
+#include "DrawDataRecording.h"
+
+#include <cstring>
+#include <limits>
+
+namespace QtImGui {
+
+namespace {
+
+const char kMagic[4] = { 'Q', 'I', 'D', 'R' };
+const quint32 kVersion = 1;
+
+// Serialized sizes: a list's command, vertex and index counts, and a command
+const size_t kListHeaderSize = 3 * sizeof(quint32);
+const size_t kCommandSize = sizeof(ImVec4) + sizeof(quint64) + 3 * sizeof(quint32) + sizeof(quint8);
+
+// Callback markers of a recorded command
+const quint8 kNoCallback = 0;
+const quint8 kResetRenderState = 1;
+const quint8 kUserCallback = 2;
+
+// Fast zlib level: recording runs inside render()
+const int kCompressionLevel = 1;
+
+template<typename T>
+void append(QByteArray &out, const T &value)
+{
+    out.append(reinterpret_cast<const char*>(&value), int(sizeof(T)));
+}
+
+void appendBytes(QByteArray &out, const void *data, size_t size)
+{
+    out.append(reinterpret_cast<const char*>(data), int(size));
+}
+
+// Bounds-checked reads from a frame payload
+class Cursor {
+public:
+    explicit Cursor(const QByteArray &data) : m_data(data) {}
+
+    template<typename T>
+    bool read(T &value) { return readBytes(&value, sizeof(T)); }
+
+    bool readBytes(void *dst, size_t size)
+    {
+        if (m_pos + size > size_t(m_data.size()))
+            return false;
+        if (size > 0)
+            memcpy(dst, m_data.constData() + m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    // Whether `count` records of `recordSize` bytes can still be read, checked before
+    // allocating for counts read from the file
+    bool fits(quint64 count, size_t recordSize) const
+    {
+        return count * recordSize <= quint64(m_data.size()) - m_pos;
+    }
+
+private:
+    const QByteArray &m_data;
+    size_t m_pos = 0;
+};
+
+void xorInPlace(QByteArray &data, const QByteArray &reference)
+{
+    const int n = qMin(data.size(), reference.size());
+    char *d = data.data();
+    const char *r = reference.constData();
+    for (int i = 0; i < n; i++)
+        d[i] ^= r[i];
+}
+
+} // namespace
+
+DrawDataWriter::DrawDataWriter()
+{
+}
+
+DrawDataWriter::~DrawDataWriter()
+{
+    close();
+}
+
+bool DrawDataWriter::open(const QString &path)
+{
+    ImGuiIO &io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    return open(path, QImage(pixels, width, height, width * 4, QImage::Format_RGBA8888), io.Fonts->TexID);
+}
+
+bool DrawDataWriter::open(const QString &path, const QImage &atlasImage, ImTextureID fontTexture)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("QtImGui: cannot open %s for draw data recording", qPrintable(path));
+        return false;
+    }
+
+    const QImage rgba = atlasImage.convertToFormat(QImage::Format_RGBA8888);
+    const int width = rgba.width(), height = rgba.height();
+    QByteArray pixels;
+    pixels.reserve(width * height * 4);
+    for (int y = 0; y < height; y++)
+        pixels.append(reinterpret_cast<const char*>(rgba.constScanLine(y)), width * 4);
+    const QByteArray atlas = qCompress(pixels, kCompressionLevel);
+
+    QByteArray header;
+    header.append(kMagic, 4);
+    append(header, kVersion);
+    append(header, quint32(sizeof(ImDrawVert)));
+    append(header, quint32(sizeof(ImDrawIdx)));
+    append(header, quint64(reinterpret_cast<quintptr>(fontTexture)));
+    append(header, quint32(width));
+    append(header, quint32(height));
+    append(header, quint32(atlas.size()));
+    header.append(atlas);
+
+    m_bytes = m_file.write(header);
+    m_frames = 0;
+    m_previous.clear();
+    return true;
+}
+
+void DrawDataWriter::write(const ImDrawData *drawData)
+{
+    if (!m_file.isOpen() || !drawData)
+        return;
+
+    m_raw.resize(0);
+    append(m_raw, drawData->DisplayPos);
+    append(m_raw, drawData->DisplaySize);
+    append(m_raw, drawData->FramebufferScale);
+    append(m_raw, quint32(drawData->CmdListsCount));
+
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList *list = drawData->CmdLists[n];
+        append(m_raw, quint32(list->CmdBuffer.Size));
+        append(m_raw, quint32(list->VtxBuffer.Size));
+        append(m_raw, quint32(list->IdxBuffer.Size));
+
+        for (const ImDrawCmd &cmd : list->CmdBuffer) {
+            append(m_raw, cmd.ClipRect);
+            append(m_raw, quint64(reinterpret_cast<quintptr>(cmd.TextureId)));
+            append(m_raw, quint32(cmd.VtxOffset));
+            append(m_raw, quint32(cmd.IdxOffset));
+            append(m_raw, quint32(cmd.ElemCount));
+            const quint8 callback = !cmd.UserCallback ? kNoCallback
+                : cmd.UserCallback == ImDrawCallback_ResetRenderState ? kResetRenderState : kUserCallback;
+            append(m_raw, callback);
+        }
+        appendBytes(m_raw, list->VtxBuffer.Data, size_t(list->VtxBuffer.Size) * sizeof(ImDrawVert));
+        appendBytes(m_raw, list->IdxBuffer.Data, size_t(list->IdxBuffer.Size) * sizeof(ImDrawIdx));
+    }
+
+    const bool keyframe = (m_frames % kKeyframeInterval) == 0;
+    QByteArray payload = m_raw;
+    if (!keyframe)
+        xorInPlace(payload, m_previous);
+    const QByteArray compressed = qCompress(payload, kCompressionLevel);
+    m_previous.swap(m_raw);
+
+    QByteArray record;
+    append(record, quint32(m_previous.size()));
+    append(record, quint32(compressed.size()));
+    append(record, quint8(keyframe ? 1 : 0));
+    record.append(compressed);
+    m_bytes += m_file.write(record);
+    m_frames++;
+}
+
+void DrawDataWriter::close()
+{
+    m_file.close();
+    m_previous.clear();
+}
+
+DrawDataReader::DrawDataReader()
+{
+}
+
+DrawDataReader::~DrawDataReader()
+{
+    for (ImDrawList *list : m_lists)
+        IM_DELETE(list);
+}
+
+bool DrawDataReader::open(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning("QtImGui: cannot open draw data recording %s", qPrintable(path));
+        return false;
+    }
+
+    char magic[4];
+    quint32 version = 0, vertexSize = 0, indexSize = 0, width = 0, height = 0, atlasSize = 0;
+    quint64 fontTexture = 0;
+    const bool ok = m_file.read(magic, 4) == 4 && memcmp(magic, kMagic, 4) == 0
+        && m_file.read(reinterpret_cast<char*>(&version), 4) == 4 && version == kVersion
+        && m_file.read(reinterpret_cast<char*>(&vertexSize), 4) == 4 && vertexSize == sizeof(ImDrawVert)
+        && m_file.read(reinterpret_cast<char*>(&indexSize), 4) == 4 && indexSize == sizeof(ImDrawIdx)
+        && m_file.read(reinterpret_cast<char*>(&fontTexture), 8) == 8
+        && m_file.read(reinterpret_cast<char*>(&width), 4) == 4
+        && m_file.read(reinterpret_cast<char*>(&height), 4) == 4
+        && m_file.read(reinterpret_cast<char*>(&atlasSize), 4) == 4;
+    if (!ok) {
+        qWarning("QtImGui: %s is not a draw data recording of this build (vertex/index layout)", qPrintable(path));
+        return false;
+    }
+
+    const QByteArray atlas = qUncompress(m_file.read(atlasSize));
+    if (atlas.size() != int(width * height * 4)) {
+        qWarning("QtImGui: corrupt font atlas in %s", qPrintable(path));
+        return false;
+    }
+    m_atlas = QImage(int(width), int(height), QImage::Format_RGBA8888);
+    memcpy(m_atlas.bits(), atlas.constData(), size_t(atlas.size()));
+    m_fontTexture = reinterpret_cast<ImTextureID>(quintptr(fontTexture));
+
+    m_firstFrame = m_file.pos();
+    m_previous.clear();
+    return true;
+}
+
+void DrawDataReader::rewind()
+{
+    m_file.seek(m_firstFrame);
+    m_previous.clear();
+}
+
+ImDrawData *DrawDataReader::readFrame()
+{
+    quint32 rawSize = 0, compressedSize = 0;
+    quint8 keyframe = 0;
+    if (m_file.read(reinterpret_cast<char*>(&rawSize), 4) != 4
+        || m_file.read(reinterpret_cast<char*>(&compressedSize), 4) != 4
+        || m_file.read(reinterpret_cast<char*>(&keyframe), 1) != 1)
+        return nullptr;
+    // Sizes of a truncated or corrupt file would be allocated as is
+    if (qint64(compressedSize) > m_file.size() - m_file.pos() || rawSize > quint32(std::numeric_limits<int>::max()))
+        return nullptr;
+
+    m_raw = qUncompress(m_file.read(compressedSize));
+    if (m_raw.size() != int(rawSize))
+        return nullptr;
+    if (!keyframe)
+        xorInPlace(m_raw, m_previous);
+    m_previous = m_raw;
+
+    Cursor in(m_raw);
+    quint32 listCount = 0;
+    if (!in.read(m_drawData.DisplayPos) || !in.read(m_drawData.DisplaySize)
+        || !in.read(m_drawData.FramebufferScale) || !in.read(listCount)
+        || !in.fits(listCount, kListHeaderSize))
+        return nullptr;
+
+    while (m_lists.Size < int(listCount))
+        m_lists.push_back(IM_NEW(ImDrawList)(nullptr));
+
+    m_drawData.TotalVtxCount = 0;
+    m_drawData.TotalIdxCount = 0;
+    for (quint32 n = 0; n < listCount; n++) {
+        ImDrawList *list = m_lists[int(n)];
+        quint32 cmdCount = 0, vtxCount = 0, idxCount = 0;
+        if (!in.read(cmdCount) || !in.read(vtxCount) || !in.read(idxCount)
+            || !in.fits(quint64(cmdCount) * kCommandSize + quint64(vtxCount) * sizeof(ImDrawVert)
+                        + quint64(idxCount) * sizeof(ImDrawIdx), 1))
+            return nullptr;
+
+        list->CmdBuffer.resize(int(cmdCount));
+        for (ImDrawCmd &cmd : list->CmdBuffer) {
+            quint64 texture = 0;
+            quint32 vtxOffset = 0, idxOffset = 0, elemCount = 0;
+            quint8 callback = 0;
+            if (!in.read(cmd.ClipRect) || !in.read(texture) || !in.read(vtxOffset)
+                || !in.read(idxOffset) || !in.read(elemCount) || !in.read(callback))
+                return nullptr;
+            cmd.TextureId = reinterpret_cast<ImTextureID>(quintptr(texture));
+            cmd.VtxOffset = vtxOffset;
+            cmd.IdxOffset = idxOffset;
+            cmd.ElemCount = elemCount;
+            // Other callbacks pointed into the recording process, they become empty commands
+            cmd.UserCallback = callback == kResetRenderState ? ImDrawCallback_ResetRenderState : nullptr;
+            cmd.UserCallbackData = nullptr;
+            if (callback == kUserCallback)
+                cmd.ElemCount = 0;
+        }
+
+        list->VtxBuffer.resize(int(vtxCount));
+        list->IdxBuffer.resize(int(idxCount));
+        if (!in.readBytes(list->VtxBuffer.Data, size_t(vtxCount) * sizeof(ImDrawVert))
+            || !in.readBytes(list->IdxBuffer.Data, size_t(idxCount) * sizeof(ImDrawIdx)))
+            return nullptr;
+
+        // Commands must stay within the buffers, backends index them unchecked
+        for (const ImDrawCmd &cmd : list->CmdBuffer) {
+            if (quint64(cmd.IdxOffset) + cmd.ElemCount > idxCount || cmd.VtxOffset > vtxCount)
+                return nullptr;
+            for (unsigned int i = 0; i < cmd.ElemCount; i++) {
+                if (list->IdxBuffer[int(cmd.IdxOffset + i)] >= vtxCount - cmd.VtxOffset)
+                    return nullptr;
+            }
+        }
+
+        m_drawData.TotalVtxCount += int(vtxCount);
+        m_drawData.TotalIdxCount += int(idxCount);
+    }
+
+    m_drawData.Valid = true;
+    m_drawData.CmdListsCount = int(listCount);
+    m_drawData.CmdLists = m_lists.Data;
+    return &m_drawData;
+}
+
+void DrawDataReader::remapTextures(ImTextureID font, ImTextureID other)
+{
+    for (int n = 0; n < m_drawData.CmdListsCount; n++) {
+        for (ImDrawCmd &cmd : m_lists[n]->CmdBuffer)
+            cmd.TextureId = cmd.TextureId == m_fontTexture ? font : other;
+    }
+}
+
+} // namespace QtImGui
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <imgui.h>
+
+namespace QtImGui {
+
+// Binary recording of ImDrawData, for replaying production frames offline.
+//
+// A file starts with a header holding the font atlas (RGBA, compressed) and the texture
+// id it had when recording. Each frame then stores the display rect and scale, the draw
+// lists with their commands, vertices and indices. Frames are XOR'ed against the previous
+// one before compression, so the unchanged parts of a mostly static UI compress to almost
+// nothing; every kKeyframeInterval-th frame is stored whole. User callbacks cannot be
+// recorded, only ImDrawCallback_ResetRenderState survives a round trip.
+//
+// Data is written in native byte order, recordings are not portable across endianness.
+class DrawDataWriter {
+public:
+    DrawDataWriter();
+    ~DrawDataWriter();
+
+    // Writes the header, with the atlas of the current ImGui context
+    bool open(const QString &path);
+    // Same with a given atlas, in QImage::Format_RGBA8888, usable outside of the context's thread
+    bool open(const QString &path, const QImage &atlas, ImTextureID fontTexture);
+    void write(const ImDrawData *drawData);
+    void close();
+
+    int frameCount() const { return m_frames; }
+    qint64 bytesWritten() const { return m_bytes; }
+
+    static const int kKeyframeInterval = 120;
+
+private:
+    QFile m_file;
+    QByteArray m_raw;
+    QByteArray m_previous;
+    int m_frames = 0;
+    qint64 m_bytes = 0;
+};
+
+class DrawDataReader {
+public:
+    DrawDataReader();
+    ~DrawDataReader();
+
+    bool open(const QString &path);
+
+    // Next frame, nullptr at the end of the recording or on a corrupt frame. The draw data
+    // and its lists stay valid until the next call; buffers are reused between frames.
+    ImDrawData *readFrame();
+
+    // Back to the first frame
+    void rewind();
+
+    // Font atlas of the recording, in QImage::Format_RGBA8888
+    const QImage &fontAtlas() const { return m_atlas; }
+
+    // Texture id of the atlas when recording. Draw commands keep their recorded ids,
+    // map them to replay textures with remapTextures().
+    ImTextureID recordedFontTexture() const { return m_fontTexture; }
+
+    // Replaces the recorded font texture id by `font`, and every other id by `other`
+    void remapTextures(ImTextureID font, ImTextureID other);
+
+private:
+    QFile m_file;
+    qint64 m_firstFrame = 0;
+    QImage m_atlas;
+    ImTextureID m_fontTexture = nullptr;
+    QByteArray m_raw;
+    QByteArray m_previous;
+    ImDrawData m_drawData;
+    ImVector<ImDrawList*> m_lists;
+};
+
+} // namespace QtImGui
@@ -0,0 +1,138 @@
+#include "DrawDataSnapshot.h"
+
+#include <cstring>
+
+namespace QtImGui {
+
+namespace {
+
+// Copies src into dst without giving back dst's capacity (ImVector::operator= frees it).
+// Returns true when dst had to grow.
+template<typename T>
+bool copyVector(ImVector<T> &dst, const ImVector<T> &src)
+{
+    const bool grow = src.Size > dst.Capacity;
+    dst.resize(src.Size);
+    if (src.Size > 0)
+        memcpy(dst.Data, src.Data, (size_t)src.Size * sizeof(T));
+    return grow;
+}
+
+} // namespace
+
+DrawDataSnapshot::DrawDataSnapshot()
+{
+}
+
+DrawDataSnapshot::~DrawDataSnapshot()
+{
+    clear();
+}
+
+int DrawDataSnapshot::capture(ImDrawData *src, Mode mode)
+{
+    int allocations = 0;
+
+    if (src->CmdListsCount > m_lists.Capacity)
+        allocations++;
+    while (m_lists.Size < src->CmdListsCount) {
+        m_lists.push_back(IM_NEW(ImDrawList)(nullptr));
+        allocations++;
+    }
+
+    for (int n = 0; n < src->CmdListsCount; n++) {
+        ImDrawList *srcList = src->CmdLists[n];
+        ImDrawList *dstList = m_lists[n];
+
+        if (mode == Swap) {
+            dstList->CmdBuffer.swap(srcList->CmdBuffer);
+            dstList->IdxBuffer.swap(srcList->IdxBuffer);
+            dstList->VtxBuffer.swap(srcList->VtxBuffer);
+        } else {
+            allocations += copyVector(dstList->CmdBuffer, srcList->CmdBuffer);
+            allocations += copyVector(dstList->IdxBuffer, srcList->IdxBuffer);
+            allocations += copyVector(dstList->VtxBuffer, srcList->VtxBuffer);
+        }
+        dstList->Flags = srcList->Flags;
+        dstList->_OwnerName = srcList->_OwnerName;
+    }
+
+    m_drawData = *src;
+    m_drawData.CmdLists = m_lists.Data;
+    return allocations;
+}
+
+size_t DrawDataSnapshot::capacityBytes() const
+{
+    size_t bytes = (size_t)m_lists.Capacity * sizeof(ImDrawList*);
+    for (const ImDrawList *list : m_lists) {
+        bytes += sizeof(ImDrawList);
+        bytes += (size_t)list->CmdBuffer.Capacity * sizeof(ImDrawCmd);
+        bytes += (size_t)list->IdxBuffer.Capacity * sizeof(ImDrawIdx);
+        bytes += (size_t)list->VtxBuffer.Capacity * sizeof(ImDrawVert);
+    }
+    return bytes;
+}
+
+void DrawDataSnapshot::clear()
+{
+    for (ImDrawList *list : m_lists)
+        IM_DELETE(list);
+    m_lists.clear();
+    m_drawData.CmdLists = nullptr;
+    m_drawData.CmdListsCount = 0;
+}
+
+SnapshotPool::SnapshotPool()
+{
+}
+
+SnapshotPool::~SnapshotPool()
+{
+    qDeleteAll(m_all);
+}
+
+DrawDataSnapshot *SnapshotPool::take(ImDrawData *src, DrawDataSnapshot::Mode mode)
+{
+    DrawDataSnapshot *snapshot = nullptr;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!m_free.isEmpty()) {
+            snapshot = m_free.takeLast();
+        } else {
+            snapshot = new DrawDataSnapshot();
+            m_all.append(snapshot);
+            m_allocations++;
+        }
+    }
+
+    m_allocations += snapshot->capture(src, mode);
+    const qint64 bytes = qint64(snapshot->capacityBytes());
+    QMutexLocker lock(&m_mutex);
+    m_capacity[snapshot] = bytes;
+    return snapshot;
+}
+
+void SnapshotPool::release(DrawDataSnapshot *snapshot)
+{
+    QMutexLocker lock(&m_mutex);
+    m_free.append(snapshot);
+}
+
+qint64 SnapshotPool::capacityBytes() const
+{
+    QMutexLocker lock(&m_mutex);
+    qint64 bytes = 0;
+    for (qint64 snapshotBytes : m_capacity)
+        bytes += snapshotBytes;
+    return bytes;
+}
+
+int SnapshotPool::takeAllocationCount()
+{
+    const int allocations = m_allocations;
+    m_allocations = 0;
+    return allocations;
+}
+
+} // namespace QtImGui
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <imgui.h>
+
+namespace QtImGui {
+
+// Deep copy of an ImDrawData that stays valid after the ImGui context moved on.
+//
+// Draw lists and their buffers are kept between captures and only grow, so once
+// buffers reached the size of the largest frame, capture() does not allocate.
+class DrawDataSnapshot {
+public:
+    enum Mode {
+        // Copy vertices, indices and commands, the source is left untouched
+        Copy,
+        // Exchange buffers with the source lists instead of copying. The source lists get
+        // this snapshot's previous buffers, they must not be rendered anymore and are
+        // expected to be reset by the next ImGui::NewFrame().
+        Swap
+    };
+
+    DrawDataSnapshot();
+    ~DrawDataSnapshot();
+    DrawDataSnapshot(const DrawDataSnapshot &) = delete;
+    DrawDataSnapshot &operator=(const DrawDataSnapshot &) = delete;
+
+    // Returns the number of heap allocations this capture needed
+    int capture(ImDrawData *src, Mode mode = Copy);
+
+    ImDrawData *drawData() { return &m_drawData; }
+    const ImDrawData *drawData() const { return &m_drawData; }
+
+    // Bytes held by the pooled buffers, including unused capacity
+    size_t capacityBytes() const;
+
+    // Frees all buffers
+    void clear();
+
+private:
+    ImDrawData m_drawData;
+    ImVector<ImDrawList*> m_lists; // The first m_drawData.CmdListsCount are in use
+};
+
+// Thread-safe free list of snapshots, for handing draw data to other threads
+class SnapshotPool {
+public:
+    SnapshotPool();
+    ~SnapshotPool();
+
+    // Captures `src` into a pooled snapshot. Call from the thread owning the ImGui context.
+    DrawDataSnapshot *take(ImDrawData *src, DrawDataSnapshot::Mode mode);
+
+    // Gives a snapshot back, from any thread
+    void release(DrawDataSnapshot *snapshot);
+
+    // Heap allocations made by take() since the last call, resets the counter
+    int takeAllocationCount();
+
+    // Buffer capacity of all snapshots, as of their last capture
+    qint64 capacityBytes() const;
+
+private:
+    mutable QMutex m_mutex;
+    QVector<DrawDataSnapshot*> m_free;
+    QVector<DrawDataSnapshot*> m_all;
+    QHash<const DrawDataSnapshot*, qint64> m_capacity;   // Measured by take(), snapshots in use may be read elsewhere
+    int m_allocations = 0;
+};
+
+} // namespace QtImGui
@@ -0,0 +1,186 @@
+#include "FrameBudget.h"
+
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+
+#include "DrawDataRecording.h"
+
+Q_LOGGING_CATEGORY(lcQtImGuiFrameBudget, "qtimgui.framebudget")
+
+namespace QtImGui {
+
+namespace {
+
+qint64 listBytes(const ImDrawList *list)
+{
+    return qint64(list->VtxBuffer.Size) * sizeof(ImDrawVert) + qint64(list->IdxBuffer.Size) * sizeof(ImDrawIdx);
+}
+
+} // namespace
+
+FrameBudget::FrameBudget()
+    : m_dumper(this)
+{
+}
+
+FrameBudget::~FrameBudget()
+{
+    // Pending dumps are still written
+    {
+        QMutexLocker lock(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_dumper.wait();
+}
+
+void FrameBudget::capture(ImDrawData *drawData, bool swapped)
+{
+    if (!isEnabled())
+        return;
+    m_vertices = drawData->TotalVtxCount;
+    m_indices = drawData->TotalIdxCount;
+    m_lists = drawData->CmdListsCount;
+
+    // Costliest lists by uploaded bytes, which track vertex and index counts
+    m_order.resize(size_t(drawData->CmdListsCount));
+    for (int n = 0; n < drawData->CmdListsCount; n++)
+        m_order[size_t(n)] = n;
+    const size_t top = std::min(m_order.size(), size_t(qMax(0, m_options.topWindows)));
+    std::partial_sort(m_order.begin(), m_order.begin() + top, m_order.end(), [drawData](int a, int b) {
+        return listBytes(drawData->CmdLists[a]) > listBytes(drawData->CmdLists[b]);
+    });
+    m_top.resize(top);
+    for (size_t i = 0; i < top; i++) {
+        const ImDrawList *list = drawData->CmdLists[m_order[i]];
+        m_top[i].owner.assign(list->_OwnerName ? list->_OwnerName : "");
+        m_top[i].vertices = list->VtxBuffer.Size;
+        m_top[i].bytes = listBytes(list);
+    }
+
+    // Whether the frame is late is only known after rendering it, by then a render thread
+    // has taken the buffers; a frame rendered in place is only copied if it is late
+    m_drawData = nullptr;
+    m_frameCopied = false;
+    if (!m_options.dumpDirectory.isEmpty()) {
+        if (swapped)
+            copyFrame(drawData);
+        else
+            m_drawData = drawData;
+    }
+}
+
+void FrameBudget::copyFrame(ImDrawData *drawData)
+{
+    if (!m_frame)
+        m_frame.reset(new DrawDataSnapshot);
+    m_frame->capture(drawData, DrawDataSnapshot::Copy);
+    m_frameCopied = true;
+}
+
+void FrameBudget::check(quint64 frame, float newFrameMs, float buildMs, float renderMs, const FrameStats &stats)
+{
+    ImDrawData *drawData = m_drawData;
+    m_drawData = nullptr;
+    const double totalMs = double(newFrameMs) + buildMs + renderMs;
+    if (!isEnabled() || totalMs <= m_options.budgetMs)
+        return;
+    m_overBudgetFrames++;
+
+    QString windows;
+    for (size_t i = 0; i < m_top.size(); i++) {
+        windows += QString::fromLatin1("%1\"%2\" %3 vtx %4 KiB")
+                       .arg(QLatin1String(i > 0 ? ", " : ""))
+                       .arg(QString::fromStdString(m_top[i].owner))
+                       .arg(m_top[i].vertices)
+                       .arg(m_top[i].bytes / 1024.0, 0, 'f', 1);
+    }
+
+    const QString gpu = stats.gpuMs >= 0.0 ? QString::fromLatin1(", GPU %1 ms").arg(stats.gpuMs, 0, 'f', 2) : QString();
+    qCWarning(lcQtImGuiFrameBudget,
+              "frame %llu took %.2f ms (budget %.2f ms): newFrame %.2f, build %.2f, render %.2f ms%s; "
+              "%d vertices, %d indices, %d draw lists; top: %s; "
+              "possible GL stalls: %d glGet/glIsEnabled queries, %d buffer reallocations, %d draw calls",
+              (unsigned long long)frame, totalMs, m_options.budgetMs, double(newFrameMs), double(buildMs),
+              double(renderMs), qPrintable(gpu), m_vertices, m_indices, m_lists, qPrintable(windows),
+              stats.queries, stats.bufferReallocations, stats.drawCalls);
+
+    if (!m_options.dumpDirectory.isEmpty()) {
+        if (drawData)
+            copyFrame(drawData);
+        if (m_frameCopied)
+            dump(frame);
+    }
+}
+
+void FrameBudget::dump(quint64 frame)
+{
+    Dump job;
+    job.directory = m_options.dumpDirectory;
+    job.path = QDir(job.directory).filePath(QString::fromLatin1("frame-%1.qidr").arg(frame));
+    job.maxDumps = qMax(1, m_options.maxDumps);
+
+    // The atlas belongs to the context, the dumper gets a copy
+    unsigned char *pixels = nullptr;
+    int width = 0, height = 0;
+    ImGuiIO &io = ImGui::GetIO();
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    job.atlas = QImage(pixels, width, height, width * 4, QImage::Format_RGBA8888).copy();
+    job.fontTexture = io.Fonts->TexID;
+
+    {
+        QMutexLocker lock(&m_mutex);
+        // A dumper that cannot keep up loses frames rather than memory
+        if (int(m_pending.size()) >= job.maxDumps) {
+            qCWarning(lcQtImGuiFrameBudget, "frame %llu not recorded, %d recordings pending",
+                      (unsigned long long)frame, int(m_pending.size()));
+            return;
+        }
+        job.frame = std::move(m_frame);
+        m_frameCopied = false;
+        m_pending.push_back(std::move(job));
+        m_cond.wakeAll();
+    }
+    if (!m_dumper.isRunning())
+        m_dumper.start(QThread::LowPriority);
+}
+
+void FrameBudget::writeDumps()
+{
+    forever {
+        Dump job;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!m_quit && m_pending.empty())
+                m_cond.wait(&m_mutex);
+            if (m_pending.empty())
+                return;
+            job = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+        writeDump(job);
+    }
+}
+
+void FrameBudget::writeDump(Dump &job)
+{
+    QDir dir(job.directory);
+    if (!dir.exists() && !dir.mkpath(QStringLiteral("."))) {
+        qCWarning(lcQtImGuiFrameBudget, "cannot create %s", qPrintable(job.directory));
+        return;
+    }
+
+    DrawDataWriter writer;
+    if (!writer.open(job.path, job.atlas, job.fontTexture))
+        return;
+    writer.write(job.frame->drawData());
+    writer.close();
+    qCInfo(lcQtImGuiFrameBudget, "recorded to %s", qPrintable(job.path));
+
+    m_dumps.enqueue(job.path);
+    while (m_dumps.size() > job.maxDumps)
+        QFile::remove(m_dumps.dequeue());
+}
+
+} // namespace QtImGui
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QImage>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <imgui.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DrawDataSnapshot.h"
+#include "FrameStats.h"
+
+Q_DECLARE_LOGGING_CATEGORY(lcQtImGuiFrameBudget)
+
+namespace QtImGui {
+
+struct FrameBudgetOptions {
+    double budgetMs = 0.0;      // newFrame + UI build + render; 0 disables the watchdog
+    int topWindows = 5;         // Costliest draw lists listed in the report
+    QString dumpDirectory;      // Over-budget frames are recorded there when set, see DrawDataWriter
+    int maxDumps = 8;           // Only the last maxDumps recordings are kept
+};
+
+// Reports the frames of a renderer that exceed a CPU time budget.
+//
+// Each over-budget frame logs a warning to the "qtimgui.framebudget" category with its
+// phase times, its vertex and draw list counts, its costliest draw lists and the GL calls
+// of the last pass that may stall (glGet* queries, buffer reallocations). With a dump
+// directory, the frame's draw data is also written as a one-frame recording, for
+// qtimgui_replay_bench, by a worker thread so the late frame is not delayed further.
+class FrameBudget {
+public:
+    FrameBudget();
+    ~FrameBudget();
+
+    void setOptions(const FrameBudgetOptions &options) { m_options = options; }
+    const FrameBudgetOptions &options() const { return m_options; }
+    bool isEnabled() const { return m_options.budgetMs > 0.0; }
+
+    // Called by the renderer before `drawData` is rendered. `swapped` tells that it is handed
+    // to a render thread, which takes the buffers of its lists: with a dump directory the frame
+    // is copied then. Otherwise `drawData` must stay valid until check().
+    void capture(ImDrawData *drawData, bool swapped);
+
+    // Called by the renderer at the end of render(), in the frame's ImGui context. With a
+    // dump directory, copies the frame given to capture() if it is late and was not copied.
+    void check(quint64 frame, float newFrameMs, float buildMs, float renderMs, const FrameStats &stats);
+
+    int overBudgetFrames() const { return m_overBudgetFrames; }
+
+private:
+    struct TopList {
+        std::string owner;
+        int vertices = 0;
+        qint64 bytes = 0;
+    };
+
+    struct Dump {
+        QString directory;
+        QString path;
+        int maxDumps = 0;
+        std::unique_ptr<DrawDataSnapshot> frame;
+        QImage atlas;
+        ImTextureID fontTexture = nullptr;
+    };
+
+    class Dumper : public QThread {
+    public:
+        explicit Dumper(FrameBudget *budget) : m_budget(budget) {}
+    protected:
+        void run() override { m_budget->writeDumps(); }
+    private:
+        FrameBudget *m_budget;
+    };
+
+    void copyFrame(ImDrawData *drawData);
+    void dump(quint64 frame);
+    void writeDumps();
+    void writeDump(Dump &dump);
+
+    FrameBudgetOptions m_options;
+    int m_overBudgetFrames = 0;
+
+    // The frame given to capture()
+    int m_vertices = 0;
+    int m_indices = 0;
+    int m_lists = 0;
+    std::vector<TopList> m_top;
+    std::vector<int> m_order;
+    ImDrawData *m_drawData = nullptr;   // Until check(), when the frame is not copied yet
+    std::unique_ptr<DrawDataSnapshot> m_frame;
+    bool m_frameCopied = false;
+
+    Dumper m_dumper;
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    std::deque<Dump> m_pending;
+    bool m_quit = false;
+    QQueue<QString> m_dumps;    // Written files, only touched by the dumper
+};
+
+} // namespace QtImGui
@@ -0,0 +1,264 @@
+#include "FrameRecorder.h"
+
+#include <QDir>
+#include <QOpenGLExtraFunctions>
+#include <cstring>
+
+namespace QtImGui {
+
+namespace {
+
+// Full range BT.601, as declared by C420jpeg
+inline quint8 lumaOf(int r, int g, int b)
+{
+    return quint8((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+inline quint8 cbOf(int r, int g, int b)
+{
+    return quint8(qBound(0, ((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128, 255));
+}
+
+inline quint8 crOf(int r, int g, int b)
+{
+    return quint8(qBound(0, ((128 * r - 107 * g - 21 * b + 128) >> 8) + 128, 255));
+}
+
+} // namespace
+
+FrameRecorder::FrameRecorder(QOpenGLExtraFunctions *gl, const RecorderOptions &options)
+    : m_gl(gl)
+    , m_options(options)
+    , m_writer(this)
+{
+    m_options.framesPerSecond = qMax(1, m_options.framesPerSecond);
+    m_options.maxPendingFrames = qMax(1, m_options.maxPendingFrames);
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    // Without a current context the buffers are left to the context's destruction
+    {
+        QMutexLocker lock(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_writer.wait();
+}
+
+bool FrameRecorder::start()
+{
+    if (m_options.format == RecorderOptions::Y4M) {
+        m_file.setFileName(m_options.path);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning("QtImGui: cannot open %s for recording", qPrintable(m_options.path));
+            return false;
+        }
+    } else if (!QDir().mkpath(m_options.path)) {
+        qWarning("QtImGui: cannot create %s for recording", qPrintable(m_options.path));
+        return false;
+    }
+
+    for (Slot &slot : m_slots)
+        m_gl->glGenBuffers(1, &slot.pbo);
+
+    m_clock.start();
+    m_writer.start(QThread::LowPriority);
+    return true;
+}
+
+void FrameRecorder::capture(const QSize &pixelSize)
+{
+    collect(false);
+
+    const qint64 now = m_clock.elapsed();
+    if (now < m_nextCaptureMs || pixelSize.isEmpty())
+        return;
+    // After a stall, resume at the capture rate rather than catching up
+    const qint64 interval = 1000 / m_options.framesPerSecond;
+    m_nextCaptureMs = qMax(m_nextCaptureMs + interval, now);
+
+    if (m_inFlight == kSlotCount) {
+        QMutexLocker lock(&m_mutex);
+        m_stats.droppedReadback++;
+        return;
+    }
+
+    Slot &slot = m_slots[(m_next + m_inFlight) % kSlotCount];
+    const qint64 bytes = qint64(pixelSize.width()) * pixelSize.height() * 4;
+
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (bytes != slot.bytes) {
+        m_gl->glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.bytes = bytes;
+    }
+    m_gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    m_gl->glReadPixels(0, 0, pixelSize.width(), pixelSize.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = m_gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.size = pixelSize;
+    m_inFlight++;
+
+    QMutexLocker lock(&m_mutex);
+    m_stats.captured++;
+}
+
+void FrameRecorder::collect(bool wait)
+{
+    while (m_inFlight > 0) {
+        Slot &slot = m_slots[m_next];
+        const GLsync fence = static_cast<GLsync>(slot.fence);
+        const GLenum status = m_gl->glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                                     wait ? GL_TIMEOUT_IGNORED : 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+            return;
+        m_gl->glDeleteSync(fence);
+        slot.fence = nullptr;
+
+        // A failed wait or mapping leaves the pixels unknown, the frame is dropped
+        bool queued = false;
+        {
+            QMutexLocker lock(&m_mutex);
+            if (status == GL_WAIT_FAILED) {
+                m_stats.droppedReadback++;
+            } else {
+                queued = m_queue.size() < m_options.maxPendingFrames;
+                if (!queued)
+                    m_stats.droppedWriter++;
+            }
+        }
+
+        if (queued) {
+            QImage image(slot.size, QImage::Format_RGBA8888);
+            m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+            const void *pixels = m_gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.bytes, GL_MAP_READ_BIT);
+            if (pixels) {
+                std::memcpy(image.bits(), pixels, size_t(slot.bytes));
+                m_gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            QMutexLocker lock(&m_mutex);
+            if (pixels) {
+                m_queue.enqueue(image);
+                m_cond.wakeAll();
+            } else {
+                m_stats.droppedReadback++;
+            }
+        }
+
+        m_next = (m_next + 1) % kSlotCount;
+        m_inFlight--;
+    }
+}
+
+void FrameRecorder::finish()
+{
+    collect(true);
+    for (Slot &slot : m_slots) {
+        m_gl->glDeleteBuffers(1, &slot.pbo);
+        slot.pbo = 0;
+        slot.bytes = 0;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_quit = true;
+        m_cond.wakeAll();
+    }
+    m_writer.wait();
+    m_file.close();
+}
+
+qint64 FrameRecorder::bufferBytes() const
+{
+    qint64 bytes = 0;
+    for (const Slot &slot : m_slots)
+        bytes += slot.pbo ? slot.bytes : 0;
+    return bytes;
+}
+
+FrameRecorder::Stats FrameRecorder::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+void FrameRecorder::writeFrames()
+{
+    forever {
+        QImage image;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!m_quit && m_queue.isEmpty())
+                m_cond.wait(&m_mutex);
+            // Frames already read back are still written on quit
+            if (m_queue.isEmpty())
+                break;
+            image = m_queue.dequeue();
+        }
+        writeFrame(image);
+    }
+}
+
+void FrameRecorder::writeFrame(const QImage &image)
+{
+    // GL rows are bottom-up
+    const QImage frame = image.mirrored();
+
+    bool written = true;
+    if (m_options.format == RecorderOptions::PngSequence) {
+        const QString name = QString("frame-%1.png").arg(m_frameIndex, 6, 10, QChar('0'));
+        written = frame.save(QDir(m_options.path).filePath(name), "PNG");
+    } else {
+        written = (m_streamSize.isEmpty() || frame.size() == m_streamSize);
+        if (written)
+            writeY4M(frame);
+    }
+
+    QMutexLocker lock(&m_mutex);
+    if (written) {
+        m_stats.written++;
+        m_frameIndex++;
+    } else {
+        m_stats.droppedWriter++;
+    }
+}
+
+void FrameRecorder::writeY4M(const QImage &image)
+{
+    // 4:2:0 needs even dimensions, the last odd row or column is cut
+    const int w = image.width() & ~1, h = image.height() & ~1;
+    if (m_streamSize.isEmpty()) {
+        m_streamSize = image.size();
+        m_file.write(QString("YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C420jpeg\n")
+                         .arg(w).arg(h).arg(m_options.framesPerSecond).toLatin1());
+    }
+
+    QByteArray planes(w * h + 2 * (w / 2) * (h / 2), Qt::Uninitialized);
+    quint8 *y = reinterpret_cast<quint8*>(planes.data());
+    quint8 *cb = y + w * h;
+    quint8 *cr = cb + (w / 2) * (h / 2);
+
+    for (int row = 0; row < h; row += 2) {
+        const quint8 *line0 = image.constScanLine(row);
+        const quint8 *line1 = image.constScanLine(row + 1);
+        for (int col = 0; col < w; col += 2) {
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; k++) {
+                const quint8 *p = (k < 2 ? line0 : line1) + (col + (k & 1)) * 4;
+                y[(row + k / 2) * w + col + (k & 1)] = lumaOf(p[0], p[1], p[2]);
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            const int c = (row / 2) * (w / 2) + col / 2;
+            cb[c] = cbOf(r / 4, g / 4, b / 4);
+            cr[c] = crOf(r / 4, g / 4, b / 4);
+        }
+    }
+
+    m_file.write("FRAME\n");
+    m_file.write(planes);
+}
+
+} // namespace QtImGui
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+class QOpenGLExtraFunctions;
+
+namespace QtImGui {
+
+struct RecorderOptions {
+    enum Format {
+        Y4M,            // Single raw YUV 4:2:0 stream at `path`, readable by ffmpeg/mpv
+        PngSequence,    // `path` is a directory, frames are written as frame-000000.png, ...
+    };
+
+    QString path;
+    Format format = Y4M;
+    int framesPerSecond = 30;   // Capture rate; frames rendered in between are not read back
+    int maxPendingFrames = 8;   // Frames waiting for the writer before new ones are dropped
+};
+
+// Records the frames of a renderer without stalling the GL pipeline.
+//
+// capture() is called right after a frame was drawn, with its context current. It issues
+// glReadPixels into one of a ring of pixel-pack buffers and puts a fence after it; the
+// buffer is only mapped frames later, once the fence has signaled. Finished frames go to
+// a writer thread doing the encoding and file I/O.
+//
+// Frames are dropped, and counted, when every buffer is still waiting for the GPU or when
+// the writer is more than maxPendingFrames behind.
+class FrameRecorder {
+public:
+    struct Stats {
+        int captured = 0;           // Readbacks issued
+        int written = 0;            // Frames on disk
+        int droppedReadback = 0;    // No free pixel-pack buffer, or the readback failed
+        int droppedWriter = 0;      // Writer queue full, or frame size changed (Y4M)
+    };
+
+    FrameRecorder(QOpenGLExtraFunctions *gl, const RecorderOptions &options);
+    ~FrameRecorder();
+
+    // Opens the output and starts the writer thread
+    bool start();
+
+    // Reads back the bound read framebuffer if a capture is due, collects finished readbacks
+    void capture(const QSize &pixelSize);
+
+    // Waits for the pending readbacks and the writer, releases the buffers. Needs the context current.
+    void finish();
+
+    Stats stats() const;
+
+    // Storage of the pixel-pack buffers, one frame each. Call from the thread with the context.
+    qint64 bufferBytes() const;
+
+private:
+    struct Slot {
+        unsigned int pbo = 0;
+        void *fence = nullptr;      // GLsync
+        QSize size;
+        qint64 bytes = 0;
+    };
+
+    class Writer : public QThread {
+    public:
+        explicit Writer(FrameRecorder *recorder) : m_recorder(recorder) {}
+    protected:
+        void run() override { m_recorder->writeFrames(); }
+    private:
+        FrameRecorder *m_recorder;
+    };
+
+    void collect(bool wait);
+    void writeFrames();
+    void writeFrame(const QImage &image);
+    void writeY4M(const QImage &image);
+
+    static const int kSlotCount = 3;
+
+    QOpenGLExtraFunctions *m_gl;
+    RecorderOptions m_options;
+    Slot m_slots[kSlotCount];
+    int m_next = 0;             // Oldest slot, readbacks complete in order
+    int m_inFlight = 0;
+    QElapsedTimer m_clock;
+    qint64 m_nextCaptureMs = 0;
+
+    Writer m_writer;
+    QFile m_file;
+    QSize m_streamSize;         // Y4M frame size, fixed by the header
+    int m_frameIndex = 0;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_cond;
+    QQueue<QImage> m_queue;
+    bool m_quit = false;
+    Stats m_stats;
+};
+
+} // namespace QtImGui
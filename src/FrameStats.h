@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QtGlobal>
+
+namespace QtImGui {
+
+// GL work of the last render pass, see ImGuiRenderer::frameStats()
+struct FrameStats {
+    int drawCalls = 0;              // glDrawElements
+    int binds = 0;                  // Program, VAO, buffer, texture and framebuffer bindings
+    int stateChanges = 0;           // Enable/disable, blend, scissor, viewport, uniforms, ...
+    int queries = 0;                // glGet* and glIsEnabled, each may stall the pipeline
+    int bufferOrphans = 0;          // glBufferData calls, each orphans the buffer storage
+    int bufferReallocations = 0;    // Orphans that changed the buffer size
+    qint64 bytesUploaded = 0;       // Buffer and texture data sent to the driver
+    double cpuMs = 0.0;             // Time spent submitting the pass
+    double gpuMs = -1.0;            // GPU time of a pass GpuTimer::kLatency frames old, -1 without GPU timing
+};
+
+// Running totals of the passes of a renderer, see ImGuiRenderer::totalStats()
+struct FrameTotals {
+    quint64 passes = 0;
+    quint64 drawCalls = 0;
+    quint64 binds = 0;
+    quint64 stateChanges = 0;
+    quint64 queries = 0;
+    quint64 bufferOrphans = 0;
+    quint64 bufferReallocations = 0;
+    quint64 bytesUploaded = 0;
+    double cpuMs = 0.0;
+
+    void add(const FrameStats &pass)
+    {
+        passes++;
+        drawCalls += quint64(pass.drawCalls);
+        binds += quint64(pass.binds);
+        stateChanges += quint64(pass.stateChanges);
+        queries += quint64(pass.queries);
+        bufferOrphans += quint64(pass.bufferOrphans);
+        bufferReallocations += quint64(pass.bufferReallocations);
+        bytesUploaded += quint64(pass.bytesUploaded);
+        cpuMs += pass.cpuMs;
+    }
+};
+
+} // namespace QtImGui
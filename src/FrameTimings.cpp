@@ -0,0 +1,134 @@
+#include "FrameTimings.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace QtImGui {
+
+namespace {
+
+// Bucket bounds in milliseconds, around the 60/120/144 Hz frame budgets
+const double kBucketBoundsMs[FrameTimings::kBucketCount] = { 0.25, 0.5, 1, 2, 4, 6, 8, 16, 33, 100 };
+
+} // namespace
+
+FrameTimings::FrameTimings()
+    : m_frames(size_t(kHistorySize) * PhaseCount, 0.0f)
+{
+}
+
+void FrameTimings::addFrame(float newFrameMs, float buildMs, float renderMs)
+{
+    float *row = &m_frames[size_t(m_next) * PhaseCount];
+    row[NewFrame] = newFrameMs;
+    row[Build] = buildMs;
+    row[Render] = renderMs;
+    for (int p = 0; p < PhaseCount; p++) {
+        const int bucket = int(std::lower_bound(kBucketBoundsMs, kBucketBoundsMs + kBucketCount, double(row[p])) - kBucketBoundsMs);
+        m_buckets[p][bucket]++;
+        m_sums[p] += row[p];
+    }
+    m_next = (m_next + 1) % kHistorySize;
+    m_count = std::min(m_count + 1, kHistorySize);
+}
+
+void FrameTimings::clear()
+{
+    m_next = 0;
+    m_count = 0;
+}
+
+float FrameTimings::at(Phase phase, int index) const
+{
+    // `index` 0 is the oldest frame
+    const int row = (m_next - m_count + index + kHistorySize) % kHistorySize;
+    return m_frames[size_t(row) * PhaseCount + phase];
+}
+
+FrameTimings::Summary FrameTimings::summary(Phase phase) const
+{
+    Summary result;
+    if (m_count == 0)
+        return result;
+
+    m_sorted.resize(size_t(m_count));
+    double sum = 0.0;
+    for (int i = 0; i < m_count; i++) {
+        m_sorted[size_t(i)] = at(phase, i);
+        sum += m_sorted[size_t(i)];
+    }
+    std::sort(m_sorted.begin(), m_sorted.end());
+
+    auto percentile = [this](double p) {
+        return double(m_sorted[std::min(m_sorted.size() - 1, size_t(p * m_sorted.size()))]);
+    };
+    result.mean = sum / m_count;
+    result.p50 = percentile(0.50);
+    result.p95 = percentile(0.95);
+    result.p99 = percentile(0.99);
+    result.max = m_sorted.back();
+    return result;
+}
+
+std::vector<float> FrameTimings::history(Phase phase) const
+{
+    std::vector<float> values(size_t(m_count));
+    for (int i = 0; i < m_count; i++)
+        values[size_t(i)] = at(phase, i);
+    return values;
+}
+
+FrameTimings::Histogram FrameTimings::histogram(Phase phase) const
+{
+    Histogram result;
+    result.boundsMs.assign(kBucketBoundsMs, kBucketBoundsMs + kBucketCount);
+    result.cumulative.resize(kBucketCount + 1);
+    quint64 total = 0;
+    for (int b = 0; b <= kBucketCount; b++) {
+        total += m_buckets[phase][b];
+        result.cumulative[size_t(b)] = total;
+    }
+    result.sumMs = m_sums[phase];
+    return result;
+}
+
+const char *FrameTimings::phaseName(Phase phase)
+{
+    switch (phase) {
+    case NewFrame: return "newFrame";
+    case Build: return "build";
+    case Render: return "render";
+    default: return "";
+    }
+}
+
+void FrameTimings::drawWindow(bool *open) const
+{
+    if (!ImGui::Begin("Frame timings", open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("%d frames", m_count);
+    for (int p = 0; p < PhaseCount; p++) {
+        const Phase phase = Phase(p);
+        const Summary s = summary(phase);
+        char overlay[128];
+        std::snprintf(overlay, sizeof(overlay), "p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms",
+                      s.p50, s.p95, s.p99, s.max);
+
+        // The plot scale is pinned above p99, so a single spike does not flatten the rest
+        const float scale = float(std::max(s.p99 * 1.25, 0.1));
+        auto getter = [](void *data, int index) {
+            const auto *self = static_cast<const std::pair<const FrameTimings*, Phase>*>(data);
+            return self->first->at(self->second, index);
+        };
+        std::pair<const FrameTimings*, Phase> data(this, phase);
+        ImGui::PlotLines(phaseName(phase), getter, &data, m_count, 0, overlay, 0.0f, scale,
+                         ImVec2(0.0f, 60.0f));
+    }
+    ImGui::End();
+}
+
+} // namespace QtImGui
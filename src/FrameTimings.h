@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QtGlobal>
+#include <vector>
+
+namespace QtImGui {
+
+// Rolling history of the CPU time of each frame phase, see ImGuiRenderer::frameTimings().
+//
+// Phases are measured by the renderer with a monotonic clock: NewFrame is
+// ImGuiRenderer::newFrame(), Build the time between the end of newFrame() and the start
+// of render() (the application's UI code and ImGui::Render()), Render is render() itself.
+// Only used from the GUI thread.
+class FrameTimings {
+public:
+    enum Phase {
+        NewFrame,
+        Build,
+        Render,
+        PhaseCount
+    };
+
+    struct Summary {
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    // Cumulative distribution since the renderer was created, not reset by clear()
+    struct Histogram {
+        std::vector<double> boundsMs;       // Upper bounds, the last bucket (+Inf) is implicit
+        std::vector<quint64> cumulative;    // Frames <= each bound, then all frames
+        double sumMs = 0.0;
+    };
+
+    // Frames kept in the history, about 10 seconds at 60 fps
+    static const int kHistorySize = 600;
+    static const int kBucketCount = 10;
+
+    FrameTimings();
+
+    void addFrame(float newFrameMs, float buildMs, float renderMs);
+    void clear();
+
+    // Frames in the history, at most kHistorySize
+    int frameCount() const { return m_count; }
+
+    // Percentiles over the history, in milliseconds
+    Summary summary(Phase phase) const;
+
+    // Timings of `phase`, oldest first
+    std::vector<float> history(Phase phase) const;
+
+    Histogram histogram(Phase phase) const;
+
+    // ImGui window plotting the history with its percentiles. Call between newFrame() and
+    // ImGui::Render(); `open` works as in ImGui::Begin().
+    void drawWindow(bool *open = nullptr) const;
+
+    static const char *phaseName(Phase phase);
+
+private:
+    float at(Phase phase, int index) const;
+
+    std::vector<float> m_frames;        // kHistorySize rows of PhaseCount timings
+    int m_next = 0;
+    int m_count = 0;
+    mutable std::vector<float> m_sorted;
+    quint64 m_buckets[PhaseCount][kBucketCount + 1] = {};
+    double m_sums[PhaseCount] = {};
+};
+
+} // namespace QtImGui
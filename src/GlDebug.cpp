@@ -0,0 +1,119 @@
+#include "GlDebug.h"
+
+#include <QOpenGLDebugLogger>
+
+#ifndef GL_DEBUG_SOURCE_APPLICATION
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#endif
+
+Q_LOGGING_CATEGORY(lcQtImGuiGl, "qtimgui.gl")
+
+namespace QtImGui {
+
+GlDebug::GlDebug()
+{
+}
+
+GlDebug::~GlDebug()
+{
+}
+
+bool GlDebug::initialize()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+
+    // Core entry points have no suffix, neither has KHR_debug on desktop GL
+    const bool core = context->format().version() >= (context->isOpenGLES() ? qMakePair(3, 2) : qMakePair(4, 3));
+    const char *suffix = "";
+    if (!core) {
+        if (!context->hasExtension("GL_KHR_debug"))
+            return false;
+        if (context->isOpenGLES())
+            suffix = "KHR";
+    }
+
+    auto resolve = [context, suffix](const char *name) {
+        return context->getProcAddress(QByteArray(name) + suffix);
+    };
+    m_pushDebugGroup = reinterpret_cast<PushDebugGroupFn>(resolve("glPushDebugGroup"));
+    m_popDebugGroup = reinterpret_cast<PopDebugGroupFn>(resolve("glPopDebugGroup"));
+    m_objectLabel = reinterpret_cast<ObjectLabelFn>(resolve("glObjectLabel"));
+
+    if (!m_pushDebugGroup || !m_popDebugGroup || !m_objectLabel) {
+        m_pushDebugGroup = nullptr;
+        m_popDebugGroup = nullptr;
+        m_objectLabel = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void GlDebug::pushGroup(const char *name)
+{
+    m_pushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+void GlDebug::popGroup()
+{
+    m_popDebugGroup();
+}
+
+void GlDebug::label(GLenum identifier, GLuint name, const char *label)
+{
+    if (name)
+        m_objectLabel(identifier, name, -1, label);
+}
+
+void GlDebug::setLogging(bool enabled)
+{
+    if (!enabled) {
+        if (m_logger)
+            m_logger->stopLogging();
+        return;
+    }
+
+    if (!m_logger) {
+        m_logger.reset(new QOpenGLDebugLogger);
+        if (!m_logger->initialize()) {
+            m_logger.reset();
+            return;
+        }
+        QObject::connect(m_logger.get(), &QOpenGLDebugLogger::messageLogged, &GlDebug::logMessage);
+    }
+    // Synchronous, so messages are logged from the GL call that caused them
+    m_logger->startLogging(QOpenGLDebugLogger::SynchronousLogging);
+}
+
+void GlDebug::release()
+{
+    m_logger.reset();
+    m_pushDebugGroup = nullptr;
+    m_popDebugGroup = nullptr;
+    m_objectLabel = nullptr;
+}
+
+void GlDebug::logMessage(const QOpenGLDebugMessage &message)
+{
+    // Our own groups echo back as messages
+    if (message.type() == QOpenGLDebugMessage::GroupPushType || message.type() == QOpenGLDebugMessage::GroupPopType)
+        return;
+
+    switch (message.severity()) {
+    case QOpenGLDebugMessage::HighSeverity:
+        qCCritical(lcQtImGuiGl, "%s", qPrintable(message.message()));
+        break;
+    case QOpenGLDebugMessage::MediumSeverity:
+        qCWarning(lcQtImGuiGl, "%s", qPrintable(message.message()));
+        break;
+    case QOpenGLDebugMessage::LowSeverity:
+        qCInfo(lcQtImGuiGl, "%s", qPrintable(message.message()));
+        break;
+    default:
+        qCDebug(lcQtImGuiGl, "%s", qPrintable(message.message()));
+        break;
+    }
+}
+
+} // namespace QtImGui
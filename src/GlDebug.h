@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QLoggingCategory>
+#include <QOpenGLContext>
+#include <memory>
+
+// Object identifiers of glObjectLabel(), missing from some GLES headers
+#ifndef GL_BUFFER
+#define GL_BUFFER 0x82E0
+#endif
+#ifndef GL_SHADER
+#define GL_SHADER 0x82E1
+#endif
+#ifndef GL_PROGRAM
+#define GL_PROGRAM 0x82E2
+#endif
+#ifndef GL_VERTEX_ARRAY
+#define GL_VERTEX_ARRAY 0x8074
+#endif
+
+class QOpenGLDebugLogger;
+class QOpenGLDebugMessage;
+
+Q_DECLARE_LOGGING_CATEGORY(lcQtImGuiGl)
+
+namespace QtImGui {
+
+// KHR_debug annotations of the renderer's GL work, for apitrace, RenderDoc and friends:
+// debug groups around the pass and each draw list, labels on the GL objects, and the
+// driver's debug messages forwarded to the "qtimgui.gl" logging category.
+//
+// Needs GL 4.3, GLES 3.2 or KHR_debug. Driver messages are only produced for contexts
+// created with QSurfaceFormat::DebugContext.
+class GlDebug {
+public:
+    GlDebug();
+    ~GlDebug();
+
+    // Resolves the entry points from the current context, returns false if unsupported
+    bool initialize();
+    bool isAvailable() const { return m_pushDebugGroup != nullptr; }
+
+    void pushGroup(const char *name);
+    void popGroup();
+    void label(GLenum identifier, GLuint name, const char *label);
+
+    // Starts or stops forwarding driver messages, with the context current
+    void setLogging(bool enabled);
+
+    // Drops the logger and entry points of a context going away, preferably current
+    void release();
+
+private:
+    typedef void (QOPENGLF_APIENTRYP PushDebugGroupFn)(GLenum source, GLuint id, GLsizei length, const GLchar *message);
+    typedef void (QOPENGLF_APIENTRYP PopDebugGroupFn)();
+    typedef void (QOPENGLF_APIENTRYP ObjectLabelFn)(GLenum identifier, GLuint name, GLsizei length, const GLchar *label);
+
+    static void logMessage(const QOpenGLDebugMessage &message);
+
+    PushDebugGroupFn m_pushDebugGroup = nullptr;
+    PopDebugGroupFn m_popDebugGroup = nullptr;
+    ObjectLabelFn m_objectLabel = nullptr;
+    std::unique_ptr<QOpenGLDebugLogger> m_logger;
+};
+
+} // namespace QtImGui
@@ -0,0 +1,49 @@
+#include "GlResources.h"
+
+namespace QtImGui {
+
+namespace {
+
+std::atomic<quint64> g_created { 0 };
+std::atomic<quint64> g_deleted { 0 };
+std::atomic<quint64> g_leaked { 0 };
+
+} // namespace
+
+void GlResourceTracker::created(int count)
+{
+    m_created += quint64(count);
+    g_created += quint64(count);
+}
+
+void GlResourceTracker::deleted(int count)
+{
+    m_deleted += quint64(count);
+    g_deleted += quint64(count);
+}
+
+void GlResourceTracker::leaked(int count)
+{
+    m_leaked += quint64(count);
+    g_leaked += quint64(count);
+}
+
+GlResourceStats GlResourceTracker::stats() const
+{
+    GlResourceStats s;
+    s.created = m_created;
+    s.deleted = m_deleted;
+    s.leaked = m_leaked;
+    return s;
+}
+
+GlResourceStats GlResourceTracker::processStats()
+{
+    GlResourceStats s;
+    s.created = g_created;
+    s.deleted = g_deleted;
+    s.leaked = g_leaked;
+    return s;
+}
+
+} // namespace QtImGui
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QtGlobal>
+#include <atomic>
+
+namespace QtImGui {
+
+// GL object counts, see ImGuiRenderer::glResourceStats()
+struct GlResourceStats {
+    quint64 created = 0;
+    quint64 deleted = 0;
+    quint64 leaked = 0;     // Names dropped without glDelete*: their context could not be made current
+
+    // Objects that should still exist on a context
+    qint64 live() const { return qint64(created) - qint64(deleted) - qint64(leaked); }
+};
+
+// Counts the GL objects (programs, shaders, buffers, VAOs, textures, queries) a renderer
+// creates and deletes, and also adds them to process-wide totals that survive the
+// renderer. Once every renderer is gone the process-wide live() count should be 0 and
+// leaked stays at 0 unless a context was lost without being current.
+//
+// Thread-safe: objects are created and deleted on whichever thread owns the context.
+class GlResourceTracker {
+public:
+    void created(int count = 1);
+    void deleted(int count = 1);
+    void leaked(int count = 1);
+
+    GlResourceStats stats() const;
+    static GlResourceStats processStats();
+
+private:
+    std::atomic<quint64> m_created { 0 };
+    std::atomic<quint64> m_deleted { 0 };
+    std::atomic<quint64> m_leaked { 0 };
+};
+
+} // namespace QtImGui
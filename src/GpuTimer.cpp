@@ -0,0 +1,169 @@
+#include "GpuTimer.h"
+
+#include <QOpenGLExtraFunctions>
+#include <algorithm>
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+namespace QtImGui {
+
+GpuTimer::GpuTimer()
+{
+}
+
+bool GpuTimer::initialize(QOpenGLExtraFunctions *gl, GlResourceTracker *resources)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context)
+        return false;
+
+    m_gl = gl;
+    m_resources = resources;
+    const bool desktop = !context->isOpenGLES()
+        && (context->format().version() >= qMakePair(3, 3) || context->hasExtension("GL_ARB_timer_query"));
+    if (desktop) {
+        m_queryCounter = reinterpret_cast<QueryCounterFn>(context->getProcAddress("glQueryCounter"));
+        m_getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64vFn>(context->getProcAddress("glGetQueryObjectui64v"));
+    } else if (context->hasExtension("GL_EXT_disjoint_timer_query")) {
+        m_queryCounter = reinterpret_cast<QueryCounterFn>(context->getProcAddress("glQueryCounterEXT"));
+        m_getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64vFn>(context->getProcAddress("glGetQueryObjectui64vEXT"));
+    }
+
+    if (!m_queryCounter || !m_getQueryObjectui64v) {
+        m_queryCounter = nullptr;
+        m_getQueryObjectui64v = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void GpuTimer::timestamp(Frame &frame)
+{
+    if (frame.used == int(frame.queries.size())) {
+        GLuint query = 0;
+        m_gl->glGenQueries(1, &query);
+        frame.queries.push_back(query);
+        if (m_resources)
+            m_resources->created();
+    }
+    m_queryCounter(frame.queries[size_t(frame.used++)], GL_TIMESTAMP);
+}
+
+void GpuTimer::beginPass(const ImDrawData *drawData)
+{
+    if (!isAvailable())
+        return;
+
+    // Results not available after kLatency frames are given up, the slot is reused
+    Frame &frame = m_frames[m_current];
+    if (frame.pending) {
+        m_dropped++;
+        frame.pending = false;
+        m_pending--;
+        m_oldest = (m_current + 1) % (kLatency + 1);
+    }
+
+    frame.used = 0;
+    frame.owners.resize(size_t(drawData->CmdListsCount));
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const char *owner = drawData->CmdLists[n]->_OwnerName;
+        frame.owners[size_t(n)].assign(owner ? owner : "");
+    }
+    timestamp(frame);
+}
+
+void GpuTimer::endList(int index)
+{
+    if (!isAvailable())
+        return;
+    Frame &frame = m_frames[m_current];
+    // One timestamp per list, in order, after the start one
+    if (frame.used == index + 1)
+        timestamp(frame);
+}
+
+void GpuTimer::endPass()
+{
+    if (!isAvailable())
+        return;
+    m_frames[m_current].pending = true;
+    m_pending++;
+    m_current = (m_current + 1) % (kLatency + 1);
+}
+
+bool GpuTimer::collect()
+{
+    if (!isAvailable())
+        return false;
+
+    bool collected = false;
+    while (m_pending > 0) {
+        Frame &frame = m_frames[m_oldest];
+
+        // Timestamps complete in order, the last one being ready means all are
+        GLuint available = 0;
+        m_gl->glGetQueryObjectuiv(frame.queries[size_t(frame.used - 1)], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        m_times.resize(size_t(frame.used));
+        for (int i = 0; i < frame.used; i++)
+            m_getQueryObjectui64v(frame.queries[size_t(i)], GL_QUERY_RESULT, &m_times[size_t(i)]);
+
+        m_passMs = (m_times.back() - m_times.front()) / 1e6;
+        const size_t lists = std::min(frame.owners.size(), m_times.size() - 1);
+        m_lists.resize(lists);
+        for (size_t i = 0; i < lists; i++) {
+            m_lists[i].owner = frame.owners[i];
+            m_lists[i].ms = (m_times[i + 1] - m_times[i]) / 1e6;
+        }
+
+        frame.pending = false;
+        m_pending--;
+        m_oldest = (m_oldest + 1) % (kLatency + 1);
+        collected = true;
+    }
+    return collected;
+}
+
+void GpuTimer::release()
+{
+    for (Frame &frame : m_frames) {
+        if (!frame.queries.empty() && m_gl) {
+            m_gl->glDeleteQueries(GLsizei(frame.queries.size()), frame.queries.data());
+            if (m_resources)
+                m_resources->deleted(int(frame.queries.size()));
+        }
+    }
+    reset();
+}
+
+void GpuTimer::forget()
+{
+    for (const Frame &frame : m_frames) {
+        if (!frame.queries.empty() && m_resources)
+            m_resources->leaked(int(frame.queries.size()));
+    }
+    reset();
+}
+
+void GpuTimer::reset()
+{
+    for (Frame &frame : m_frames) {
+        frame.queries.clear();
+        frame.used = 0;
+        frame.pending = false;
+    }
+    m_oldest = m_current = 0;
+    m_pending = 0;
+}
+
+} // namespace QtImGui
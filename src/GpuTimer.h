@@ -0,0 +1,88 @@
+#pragma once
+
+#include <QOpenGLContext>
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+#include "GlResources.h"
+
+class QOpenGLExtraFunctions;
+
+namespace QtImGui {
+
+// GPU time of a draw list, named after the ImGui window that owns it
+struct ListGpuTime {
+    std::string owner;
+    double ms = 0.0;
+};
+
+// GL_TIMESTAMP queries around a render pass and after each of its draw lists.
+//
+// Queries are pooled per frame in a small ring and read back kLatency frames later,
+// only once their results are available, so timing never stalls the pipeline. A frame
+// whose results are still pending when its slot comes around again is dropped.
+//
+// Needs glQueryCounter: desktop GL 3.3 / ARB_timer_query, or EXT_disjoint_timer_query on
+// GLES. Disjoint events (GPU frequency changes) are not detected.
+class GpuTimer {
+public:
+    GpuTimer();
+
+    // Resolves the entry points from the current context, returns false if unsupported.
+    // Queries are counted in `resources` when given.
+    bool initialize(QOpenGLExtraFunctions *gl, GlResourceTracker *resources = nullptr);
+    bool isAvailable() const { return m_queryCounter != nullptr; }
+
+    // Call with the context current: beginPass(), endList() after each draw list, endPass()
+    void beginPass(const ImDrawData *drawData);
+    void endList(int index);
+    void endPass();
+
+    // Reads the oldest frames whose results are ready. Returns true when a new result
+    // was read, then available from passMs() and lists().
+    bool collect();
+
+    double passMs() const { return m_passMs; }
+    const std::vector<ListGpuTime> &lists() const { return m_lists; }
+    int droppedFrames() const { return m_dropped; }
+
+    // Deletes the queries, with the context current
+    void release();
+
+    // Drops the queries of a context that cannot be made current anymore, counted as leaked
+    void forget();
+
+    static const int kLatency = 3;
+
+private:
+    typedef void (QOPENGLF_APIENTRYP QueryCounterFn)(GLuint id, GLenum target);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64vFn)(GLuint id, GLenum pname, quint64 *params);
+
+    struct Frame {
+        std::vector<GLuint> queries;        // Start, then one per list; grows, never shrinks
+        std::vector<std::string> owners;    // Keeps its capacity between frames
+        int used = 0;
+        bool pending = false;
+    };
+
+    void timestamp(Frame &frame);
+
+    void reset();
+
+    QOpenGLExtraFunctions *m_gl = nullptr;
+    GlResourceTracker *m_resources = nullptr;
+    QueryCounterFn m_queryCounter = nullptr;
+    GetQueryObjectui64vFn m_getQueryObjectui64v = nullptr;
+
+    Frame m_frames[kLatency + 1];
+    int m_current = 0;      // Frame being recorded
+    int m_oldest = 0;       // Oldest pending frame, results complete in order
+    int m_pending = 0;
+    double m_passMs = -1.0;
+    std::vector<quint64> m_times;
+    std::vector<ListGpuTime> m_lists;
+    int m_dropped = 0;
+};
+
+} // namespace QtImGui
@@ -0,0 +1,527 @@
+#include "ImGuiAllocator.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace QtImGui {
+
+namespace {
+
+// Keeps the blocks handed to ImGui 16-byte aligned, like malloc()
+const size_t kHeaderSize = 32;
+
+struct Header {
+    size_t size;
+    ContextHeap *heap;
+    void *region;
+};
+static_assert(sizeof(Header) <= kHeaderSize, "allocation header too large");
+
+// Pool size classes, in bytes including the header, about 1.5x apart
+const size_t kClassSizes[] = { 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096 };
+const int kClassCount = int(sizeof(kClassSizes) / sizeof(kClassSizes[0]));
+
+size_t alignUp(size_t size)
+{
+    return (size + 15) & ~size_t(15);
+}
+
+// Nesting of Allocator::TransientScope on the thread
+thread_local int t_transientDepth = 0;
+
+// ImGui's allocator functions before install(), heaps take their memory from them
+ImGuiMemAllocFunc g_parentAlloc = nullptr;
+ImGuiMemFreeFunc g_parentFree = nullptr;
+void *g_parentUserData = nullptr;
+
+void *parentAlloc(size_t size)
+{
+    return g_parentAlloc ? g_parentAlloc(size, g_parentUserData) : std::malloc(size);
+}
+
+void parentFree(void *ptr)
+{
+    if (g_parentFree)
+        g_parentFree(ptr, g_parentUserData);
+    else
+        std::free(ptr);
+}
+
+} // namespace
+
+AllocationStats ContextHeap::stats() const
+{
+    AllocationStats s;
+    s.allocations = m_allocations.load(std::memory_order_relaxed);
+    s.frees = m_frees.load(std::memory_order_relaxed);
+    s.bytesAllocated = m_bytesAllocated.load(std::memory_order_relaxed);
+    s.bytesFreed = m_bytesFreed.load(std::memory_order_relaxed);
+    return s;
+}
+
+HeapStats ContextHeap::heapStats() const
+{
+    const AllocationStats s = stats();
+    HeapStats h;
+    h.reservedBytes = s.liveBytes() + s.liveAllocations() * qint64(kHeaderSize);
+    return h;
+}
+
+void *ContextHeap::allocateBlock(size_t bytes, void **region)
+{
+    *region = nullptr;
+    return parentAlloc(bytes);
+}
+
+void ContextHeap::freeBlock(void *block, size_t bytes, void *region)
+{
+    Q_UNUSED(bytes);
+    Q_UNUSED(region);
+    parentFree(block);
+}
+
+// Pool
+
+struct PoolHeap::Slab {
+    int sizeClass;
+    int live = 0;           // Blocks handed out
+    size_t carved = 0;      // Bytes of `data` split into blocks so far
+
+    static size_t headerSize() { return alignUp(sizeof(Slab)); }
+    static size_t capacity() { return kSlabSize - headerSize(); }
+    char *data() { return reinterpret_cast<char*>(this) + headerSize(); }
+};
+
+PoolHeap::PoolHeap()
+    : m_freeLists(size_t(kClassCount), nullptr)
+    , m_current(size_t(kClassCount), nullptr)
+{
+}
+
+PoolHeap::~PoolHeap()
+{
+    for (Slab *slab : m_slabs)
+        parentFree(slab);
+}
+
+int PoolHeap::sizeClass(size_t bytes)
+{
+    const size_t *c = std::lower_bound(kClassSizes, kClassSizes + kClassCount, bytes);
+    return c == kClassSizes + kClassCount ? -1 : int(c - kClassSizes);
+}
+
+void *PoolHeap::allocateBlock(size_t bytes, void **region)
+{
+    QMutexLocker lock(&m_mutex);
+    const int c = sizeClass(bytes);
+    if (c < 0) {
+        m_stats.fallbacks++;
+        m_stats.reservedBytes += qint64(bytes);
+        *region = nullptr;
+        return parentAlloc(bytes);
+    }
+
+    if (FreeBlock *block = m_freeLists[size_t(c)]) {
+        m_freeLists[size_t(c)] = block->next;
+        Slab *slab = *reinterpret_cast<Slab**>(block + 1);
+        slab->live++;
+        *region = slab;
+        return block;
+    }
+
+    const size_t blockSize = kClassSizes[c];
+    Slab *slab = m_current[size_t(c)];
+    if (!slab || slab->carved + blockSize > Slab::capacity()) {
+        void *memory = parentAlloc(kSlabSize);
+        if (!memory)
+            return nullptr;
+        slab = new (memory) Slab;
+        slab->sizeClass = c;
+        m_slabs.push_back(slab);
+        m_current[size_t(c)] = slab;
+        m_stats.reservedBytes += qint64(kSlabSize);
+    }
+    void *block = slab->data() + slab->carved;
+    slab->carved += blockSize;
+    slab->live++;
+    *region = slab;
+    return block;
+}
+
+void PoolHeap::freeBlock(void *block, size_t bytes, void *region)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!region) {
+        m_stats.reservedBytes -= qint64(bytes);
+        parentFree(block);
+        return;
+    }
+
+    // A free block holds the free-list link, then its slab
+    Slab *slab = static_cast<Slab*>(region);
+    FreeBlock *free = static_cast<FreeBlock*>(block);
+    free->next = m_freeLists[size_t(slab->sizeClass)];
+    *reinterpret_cast<Slab**>(free + 1) = slab;
+    m_freeLists[size_t(slab->sizeClass)] = free;
+    slab->live--;
+}
+
+qint64 PoolHeap::trim()
+{
+    QMutexLocker lock(&m_mutex);
+    auto empty = [](const Slab *slab) { return slab->live == 0; };
+
+    // Unlink the free blocks of empty slabs first
+    for (FreeBlock *&head : m_freeLists) {
+        FreeBlock **link = &head;
+        while (*link) {
+            if (empty(*reinterpret_cast<Slab**>(*link + 1)))
+                *link = (*link)->next;
+            else
+                link = &(*link)->next;
+        }
+    }
+
+    qint64 released = 0;
+    for (Slab *&slab : m_slabs) {
+        if (!empty(slab))
+            continue;
+        if (m_current[size_t(slab->sizeClass)] == slab)
+            m_current[size_t(slab->sizeClass)] = nullptr;
+        parentFree(slab);
+        slab = nullptr;
+        released += qint64(kSlabSize);
+    }
+    m_slabs.erase(std::remove(m_slabs.begin(), m_slabs.end(), nullptr), m_slabs.end());
+    m_stats.reservedBytes -= released;
+    return released;
+}
+
+HeapStats PoolHeap::heapStats() const
+{
+    QMutexLocker lock(&m_mutex);
+    HeapStats h = m_stats;
+    h.regions = int(m_slabs.size());
+    for (const Slab *slab : m_slabs)
+        h.cachedBytes += qint64(Slab::capacity() - size_t(slab->live) * kClassSizes[slab->sizeClass]);
+    return h;
+}
+
+// Arena
+
+struct ArenaHeap::Chunk {
+    int live = 0;           // Blocks handed out
+    size_t used = 0;
+
+    static size_t headerSize() { return alignUp(sizeof(Chunk)); }
+    static size_t capacity() { return kChunkSize - headerSize(); }
+    char *data() { return reinterpret_cast<char*>(this) + headerSize(); }
+};
+
+ArenaHeap::ArenaHeap()
+{
+}
+
+ArenaHeap::~ArenaHeap()
+{
+    trim();
+}
+
+ArenaHeap::Chunk *ArenaHeap::takeChunk()
+{
+    if (!m_freeChunks.empty()) {
+        Chunk *chunk = m_freeChunks.back();
+        m_freeChunks.pop_back();
+        return chunk;
+    }
+    void *memory = parentAlloc(kChunkSize);
+    if (!memory)
+        return nullptr;
+    m_stats.regions++;
+    m_stats.reservedBytes += qint64(kChunkSize);
+    return new (memory) Chunk;
+}
+
+void *ArenaHeap::allocateBlock(size_t bytes, void **region)
+{
+    // Large blocks would waste most of a chunk
+    if (t_transientDepth == 0 || bytes > kChunkSize / 4)
+        return m_pool.allocateBlock(bytes, region);
+
+    QMutexLocker lock(&m_mutex);
+    const size_t size = alignUp(bytes);
+    if (!m_current || m_current->used + size > Chunk::capacity()) {
+        // A chunk left with live blocks is recycled by freeBlock() once they are all freed
+        if (m_current && m_current->live == 0) {
+            m_current->used = 0;
+            m_freeChunks.push_back(m_current);
+        }
+        m_current = takeChunk();
+        if (!m_current)
+            return nullptr;
+    }
+    void *block = m_current->data() + m_current->used;
+    m_current->used += size;
+    m_current->live++;
+    // Tagged in bit 0, pool regions are slabs or null
+    *region = reinterpret_cast<void*>(reinterpret_cast<quintptr>(m_current) | 1);
+    return block;
+}
+
+void ArenaHeap::freeBlock(void *block, size_t bytes, void *region)
+{
+    const quintptr bits = reinterpret_cast<quintptr>(region);
+    if (!(bits & 1)) {
+        m_pool.freeBlock(block, bytes, region);
+        return;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    Chunk *chunk = reinterpret_cast<Chunk*>(bits & ~quintptr(1));
+    if (--chunk->live == 0 && chunk != m_current) {
+        chunk->used = 0;
+        m_freeChunks.push_back(chunk);
+    }
+}
+
+void ArenaHeap::frameBoundary()
+{
+    QMutexLocker lock(&m_mutex);
+    // Rewinds a chunk whose blocks were all freed. One holding survivors keeps being
+    // filled, it is only left for a new chunk once full.
+    if (m_current && m_current->live == 0)
+        m_current->used = 0;
+}
+
+qint64 ArenaHeap::trim()
+{
+    const qint64 pooled = m_pool.trim();
+    QMutexLocker lock(&m_mutex);
+    if (m_current && m_current->live == 0) {
+        m_current->used = 0;
+        m_freeChunks.push_back(m_current);
+        m_current = nullptr;
+    }
+    const qint64 released = qint64(m_freeChunks.size() * kChunkSize);
+    for (Chunk *chunk : m_freeChunks)
+        parentFree(chunk);
+    m_stats.regions -= int(m_freeChunks.size());
+    m_stats.reservedBytes -= released;
+    m_freeChunks.clear();
+    return pooled + released;
+}
+
+HeapStats ArenaHeap::heapStats() const
+{
+    HeapStats h = m_pool.heapStats();
+    QMutexLocker lock(&m_mutex);
+    h.reservedBytes += m_stats.reservedBytes;
+    h.regions += m_stats.regions;
+    h.cachedBytes += qint64(m_freeChunks.size() * Chunk::capacity());
+    if (m_current)
+        h.cachedBytes += qint64(Chunk::capacity() - m_current->used);
+    return h;
+}
+
+namespace Allocator {
+
+namespace {
+
+// Contexts are looked up without locking; a process has a handful of them
+const int kMaxContexts = 64;
+
+struct Slot {
+    std::atomic<ImGuiContext*> context { nullptr };
+    std::atomic<ContextHeap*> heap { nullptr };
+};
+
+Slot g_slots[kMaxContexts];
+ContextHeap g_unattributed;
+thread_local ContextHeap *t_owner = nullptr;
+
+QMutex &registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+struct Registered {
+    std::unique_ptr<ContextHeap> heap;
+    bool released = false;
+};
+
+std::vector<Registered> &heaps()
+{
+    static std::vector<Registered> instance;
+    return instance;
+}
+
+// Deletes `heap` once released and empty. Called with the registry locked.
+void deleteIfUnused(ContextHeap *heap)
+{
+    std::vector<Registered> &all = heaps();
+    for (auto it = all.begin(); it != all.end(); ++it) {
+        if (it->heap.get() == heap) {
+            if (it->released && heap->stats().liveAllocations() == 0)
+                all.erase(it);
+            return;
+        }
+    }
+}
+
+ContextHeap *heapOfCurrentContext()
+{
+    if (t_owner)
+        return t_owner;
+    if (ImGuiContext *context = ImGui::GetCurrentContext()) {
+        for (Slot &slot : g_slots) {
+            if (slot.context.load(std::memory_order_acquire) == context)
+                return slot.heap.load(std::memory_order_relaxed);
+        }
+    }
+    return &g_unattributed;
+}
+
+void *allocate(size_t size, void *)
+{
+    ContextHeap *heap = heapOfCurrentContext();
+    void *region = nullptr;
+    void *block = heap->allocateBlock(kHeaderSize + size, &region);
+    if (!block)
+        return nullptr;
+    Header *header = static_cast<Header*>(block);
+    header->size = size;
+    header->heap = heap;
+    header->region = region;
+    heap->countAllocation(size);
+    return static_cast<char*>(block) + kHeaderSize;
+}
+
+void deallocate(void *ptr, void *)
+{
+    if (!ptr)
+        return;
+    Header *header = reinterpret_cast<Header*>(static_cast<char*>(ptr) - kHeaderSize);
+    ContextHeap *heap = header->heap;
+    const size_t size = header->size;
+    heap->freeBlock(header, kHeaderSize + size, header->region);
+    // Counted last: a released heap may be deleted as soon as its last block is counted
+    if (heap->countFree(size) && heap != &g_unattributed) {
+        QMutexLocker lock(&registryMutex());
+        deleteIfUnused(heap);
+    }
+}
+
+} // namespace
+
+bool install()
+{
+    static bool installed = false;
+    QMutexLocker lock(&registryMutex());
+    if (installed)
+        return true;
+
+    // Blocks allocated by an existing context have no header, deallocate() could not free them
+    if (ImGui::GetCurrentContext()) {
+        qWarning("QtImGui: an ImGui context exists already, allocations are not tracked; "
+                 "set InitOptions::trackAllocations on the first renderer");
+        return false;
+    }
+    ImGui::GetAllocatorFunctions(&g_parentAlloc, &g_parentFree, &g_parentUserData);
+    ImGui::SetAllocatorFunctions(allocate, deallocate, nullptr);
+    installed = true;
+    return true;
+}
+
+ContextHeap *newHeap(AllocatorPolicy policy)
+{
+    std::unique_ptr<ContextHeap> heap;
+    switch (policy) {
+    case AllocatorPolicy::Pool:
+        heap.reset(new PoolHeap);
+        break;
+    case AllocatorPolicy::FrameArena:
+        heap.reset(new ArenaHeap);
+        break;
+    default:
+        heap.reset(new ContextHeap);
+        break;
+    }
+
+    QMutexLocker lock(&registryMutex());
+    Registered registered;
+    registered.heap = std::move(heap);
+    heaps().push_back(std::move(registered));
+    return heaps().back().heap.get();
+}
+
+void release(ContextHeap *heap)
+{
+    QMutexLocker lock(&registryMutex());
+    for (Registered &registered : heaps()) {
+        if (registered.heap.get() == heap)
+            registered.released = true;
+    }
+    deleteIfUnused(heap);
+}
+
+int heapCount()
+{
+    QMutexLocker lock(&registryMutex());
+    return int(heaps().size());
+}
+
+void attach(ImGuiContext *context, ContextHeap *heap)
+{
+    QMutexLocker lock(&registryMutex());
+    for (Slot &slot : g_slots) {
+        if (!slot.context.load(std::memory_order_relaxed)) {
+            slot.heap.store(heap, std::memory_order_relaxed);
+            slot.context.store(context, std::memory_order_release);
+            return;
+        }
+    }
+    qWarning("QtImGui: more than %d ImGui contexts, the others use the C heap unaccounted", kMaxContexts);
+}
+
+void detach(ImGuiContext *context)
+{
+    QMutexLocker lock(&registryMutex());
+    for (Slot &slot : g_slots) {
+        if (slot.context.load(std::memory_order_relaxed) == context)
+            slot.context.store(nullptr, std::memory_order_release);
+    }
+}
+
+ContextHeap *unattributed()
+{
+    return &g_unattributed;
+}
+
+TransientScope::TransientScope()
+{
+    t_transientDepth++;
+}
+
+TransientScope::~TransientScope()
+{
+    t_transientDepth--;
+}
+
+ScopedOwner::ScopedOwner(ContextHeap *heap)
+    : m_previous(t_owner)
+{
+    t_owner = heap;
+}
+
+ScopedOwner::~ScopedOwner()
+{
+    t_owner = m_previous;
+}
+
+} // namespace Allocator
+
+} // namespace QtImGui
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <QMutex>
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+#include "QtImGui.h"
+
+struct ImGuiContext;
+
+namespace QtImGui {
+
+// Allocations made through ImGui's allocator (IM_ALLOC, ImVector, ...)
+struct AllocationStats {
+    quint64 allocations = 0;
+    quint64 frees = 0;
+    quint64 bytesAllocated = 0;
+    quint64 bytesFreed = 0;
+
+    qint64 liveAllocations() const { return qint64(allocations) - qint64(frees); }
+    qint64 liveBytes() const { return qint64(bytesAllocated) - qint64(bytesFreed); }
+
+    // Counts between two snapshots of the same heap
+    AllocationStats operator-(const AllocationStats &earlier) const
+    {
+        AllocationStats d;
+        d.allocations = allocations - earlier.allocations;
+        d.frees = frees - earlier.frees;
+        d.bytesAllocated = bytesAllocated - earlier.bytesAllocated;
+        d.bytesFreed = bytesFreed - earlier.bytesFreed;
+        return d;
+    }
+};
+
+// Memory held by an allocator policy, see ContextHeap::heapStats()
+struct HeapStats {
+    qint64 reservedBytes = 0;       // Taken from the C heap: slabs, chunks and oversized blocks
+    qint64 cachedBytes = 0;         // Reserved but not handed out, partly released by trim()
+    int regions = 0;                // Slabs or chunks
+    quint64 fallbacks = 0;          // Blocks too large for the policy, served by the C heap
+};
+
+// Blocks of one ImGui context, with their counts. The base class allocates from the C heap.
+// Thread-safe: ImGui data is also released from render threads (snapshots).
+class ContextHeap {
+public:
+    virtual ~ContextHeap() {}
+
+    AllocationStats stats() const;
+    virtual HeapStats heapStats() const;
+
+    // Called by the renderer at the start of each frame
+    virtual void frameBoundary() {}
+
+    // Returns cached memory to the C heap, returns the number of bytes released
+    virtual qint64 trim() { return 0; }
+
+    // `bytes` includes the allocator's header. `region` is kept with the block and given
+    // back to freeBlock().
+    virtual void *allocateBlock(size_t bytes, void **region);
+    virtual void freeBlock(void *block, size_t bytes, void *region);
+
+    void countAllocation(size_t size)
+    {
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        m_bytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    }
+    // Returns true when this was the last live block
+    bool countFree(size_t size)
+    {
+        m_bytesFreed.fetch_add(size, std::memory_order_relaxed);
+        return m_frees.fetch_add(1, std::memory_order_acq_rel) + 1 == m_allocations.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<quint64> m_allocations { 0 };
+    std::atomic<quint64> m_frees { 0 };
+    std::atomic<quint64> m_bytesAllocated { 0 };
+    std::atomic<quint64> m_bytesFreed { 0 };
+};
+
+// Counting allocator installed with ImGui::SetAllocatorFunctions(), only when a renderer
+// asks for it (InitOptions::trackAllocations or an allocator policy other than Malloc).
+//
+// ImGui's allocator is process-wide, so blocks are charged to the heap of the ImGui
+// context current when they are allocated (or of the ScopedOwner active on the thread),
+// and go back to that heap when they are freed, whichever context is current then.
+// Blocks carry a 32-byte header with their size, heap and region. Heaps take their
+// memory from the allocator functions ImGui had before install().
+namespace Allocator {
+
+// Blocks allocated before install() could not be freed through it: returns false, with
+// a warning, when an ImGui context already exists. An ImFontAtlas or other ImGui object
+// created without a context must not be allocated before either.
+bool install();
+
+// New heap following `policy`
+ContextHeap *newHeap(AllocatorPolicy policy);
+
+// Gives up a heap whose context was destroyed (and detached). It is deleted at once, or
+// when the last of its blocks that outlived the context is freed.
+void release(ContextHeap *heap);
+
+// Heaps alive, released ones still holding blocks included
+int heapCount();
+
+// Serves and charges the allocations made while `context` is current to `heap`
+void attach(ImGuiContext *context, ContextHeap *heap);
+void detach(ImGuiContext *context);
+
+// Allocations outside of any attached context
+ContextHeap *unattributed();
+
+// Serves the ImGui allocations of the calling thread from the chunks of a FrameArena heap
+// while in scope. For data freed within the frame, e.g. scratch buffers of a UI build
+// step; elsewhere FrameArena behaves like Pool.
+class TransientScope {
+public:
+    TransientScope();
+    ~TransientScope();
+    TransientScope(const TransientScope &) = delete;
+    TransientScope &operator=(const TransientScope &) = delete;
+};
+
+// Routes the allocations of the calling thread to `heap` while in scope, e.g. while
+// creating a context, which is allocated before it can be attached
+class ScopedOwner {
+public:
+    explicit ScopedOwner(ContextHeap *heap);
+    ~ScopedOwner();
+
+private:
+    ContextHeap *m_previous;
+};
+
+} // namespace Allocator
+
+// Size-class free lists carved from slabs; slabs whose blocks are all free go back to
+// the C heap on trim()
+class PoolHeap : public ContextHeap {
+public:
+    PoolHeap();
+    ~PoolHeap();
+
+    HeapStats heapStats() const override;
+    qint64 trim() override;
+    void *allocateBlock(size_t bytes, void **region) override;
+    void freeBlock(void *block, size_t bytes, void *region) override;
+
+    static const size_t kSlabSize = 64 * 1024;
+
+private:
+    struct Slab;
+    struct FreeBlock { FreeBlock *next; };
+
+    static int sizeClass(size_t bytes);
+
+    mutable QMutex m_mutex;
+    std::vector<Slab*> m_slabs;
+    std::vector<FreeBlock*> m_freeLists;    // Per size class
+    std::vector<Slab*> m_current;           // Slab being carved, per size class
+    HeapStats m_stats;
+};
+
+// Bump allocation in chunks for the blocks allocated inside an Allocator::TransientScope,
+// a PoolHeap for all others: ImGui's long-lived state (windows, tables, grown ImVectors)
+// would pin chunks and never give their freed space back.
+//
+// A chunk is reused once all its blocks are freed, and the current one is rewound at
+// each frame boundary when everything carved from it was freed; trim() frees the unused
+// chunks and the pool's empty slabs.
+class ArenaHeap : public ContextHeap {
+public:
+    ArenaHeap();
+    ~ArenaHeap();
+
+    HeapStats heapStats() const override;
+    void frameBoundary() override;
+    qint64 trim() override;
+    void *allocateBlock(size_t bytes, void **region) override;
+    void freeBlock(void *block, size_t bytes, void *region) override;
+
+    static const size_t kChunkSize = 256 * 1024;
+
+private:
+    struct Chunk;
+
+    Chunk *takeChunk();
+
+    PoolHeap m_pool;
+    mutable QMutex m_mutex;
+    Chunk *m_current = nullptr;
+    std::vector<Chunk*> m_freeChunks;
+    HeapStats m_stats;
+};
+
+} // namespace QtImGui
@@ -0,0 +1,281 @@
+#include "ImGuiQuickItem.h"
+
+#include "ImGuiRenderer.h"
+#include <QCursor>
+#include <QMouseEvent>
+#include <QQuickWindow>
+#include <QRunnable>
+#include <QSGRenderNode>
+#include <QSGRendererInterface>
+#include <QThread>
+
+namespace QtImGui {
+
+namespace {
+
+class QuickItemWindowWrapper : public WindowWrapper {
+public:
+    explicit QuickItemWindowWrapper(QQuickItem *item)
+      : item(item)
+    {}
+    void installEventFilter(QObject *object) override {
+        item->installEventFilter(object);
+    }
+    QSize size() const override {
+        return QSize(int(item->width()), int(item->height()));
+    }
+    qreal devicePixelRatio() const override {
+        return item->window() ? item->window()->effectiveDevicePixelRatio() : 1.0;
+    }
+    bool isActive() const override {
+        return item->window() && item->window()->isActive();
+    }
+    QPoint mapFromGlobal(const QPoint &p) const override {
+        return item->mapFromGlobal(QPointF(p)).toPoint();
+    }
+    QObject* object() override {
+        return item;
+    }
+
+    void setCursorShape(Qt::CursorShape shape) override
+    {
+        #ifndef QT_NO_CURSOR
+            item->setCursor(shape);
+        #else
+            Q_UNUSED(shape);
+        #endif
+    }
+
+    void setCursorPos(const QPoint& local_pos) override
+    {
+        #ifndef QT_NO_CURSOR
+            // Convert position from item-space into screen-space
+            QCursor::setPos(item->mapToGlobal(QPointF(local_pos)).toPoint());
+        #else
+            Q_UNUSED(local_pos);
+        #endif
+    }
+
+private:
+    QQuickItem *item;
+};
+
+// Draws the latest snapshot handed over by the item, on the scene graph render thread
+class ImGuiQuickNode : public QSGRenderNode {
+public:
+    explicit ImGuiQuickNode(ImGuiRenderer *renderer)
+      : m_renderer(renderer)
+    {}
+
+    // Called from updatePaintNode(), while the GUI thread is blocked
+    void sync(DrawDataSnapshot *snapshot, const QSizeF &itemSize, qreal windowHeight, qreal dpr)
+    {
+        if (snapshot) {
+            if (m_snapshot)
+                m_renderer->releaseSnapshot(m_snapshot);
+            m_snapshot = snapshot;
+        }
+        m_itemSize = itemSize;
+        m_windowHeight = windowHeight;
+        m_dpr = dpr;
+    }
+
+    void render(const RenderState *state) override
+    {
+        Q_UNUSED(state);
+        if (!m_snapshot)
+            return;
+
+        // matrix() maps item coordinates to window coordinates, GL wants a bottom-left origin
+        const QPointF topLeft = matrix()->map(QPointF(0, 0));
+        const QPoint offset(qRound(topLeft.x() * m_dpr),
+                            qRound((m_windowHeight - topLeft.y() - m_itemSize.height()) * m_dpr));
+        m_renderer->renderDrawData(m_snapshot->drawData(), offset);
+    }
+
+    StateFlags changedStates() const override
+    {
+        return BlendState | ScissorState | ViewportState | CullState | DepthState;
+    }
+
+    RenderingFlags flags() const override
+    {
+        return BoundedRectRendering;
+    }
+
+    QRectF rect() const override
+    {
+        return QRectF(QPointF(0, 0), m_itemSize);
+    }
+
+private:
+    // The snapshot is owned by the renderer's pool, it is not released on destruction
+    // since the renderer may already be gone by then
+    ImGuiRenderer *m_renderer;
+    DrawDataSnapshot *m_snapshot = nullptr;
+    QSizeF m_itemSize;
+    qreal m_windowHeight = 0;
+    qreal m_dpr = 1;
+};
+
+// Releases the renderer's GL objects on the render thread, where their context is
+// current. The renderer and its ImGui context belong to the GUI thread and are deleted
+// there afterwards. A job that never runs (window not renderable anymore) is still
+// deleted, by then nothing draws.
+class RendererCleanupJob : public QRunnable {
+public:
+    explicit RendererCleanupJob(ImGuiRenderer *renderer)
+      : m_renderer(renderer)
+    {}
+    ~RendererCleanupJob()
+    {
+        if (QThread::currentThread() == m_renderer->thread())
+            delete m_renderer;
+        else
+            m_renderer->deleteLater();
+    }
+    void run() override { m_renderer->releaseGL(); }
+
+private:
+    ImGuiRenderer *m_renderer;
+};
+
+} // namespace
+
+ImGuiQuickItem::ImGuiQuickItem(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_renderer(new ImGuiRenderer())
+{
+    setFlag(ItemHasContents, true);
+    setAcceptedMouseButtons(Qt::AllButtons);
+
+    InitOptions options;
+    options.externalRendering = true;
+    m_renderer->initialize(new QuickItemWindowWrapper(this), options);
+}
+
+ImGuiQuickItem::~ImGuiQuickItem()
+{
+    disconnect(m_frameSwapped);
+    disconnect(m_sceneGraphInvalidated);
+    removeEventFilter(m_renderer);
+    if (m_pending)
+        m_renderer->releaseSnapshot(m_pending);
+
+    if (window()) {
+        window()->scheduleRenderJob(new RendererCleanupJob(m_renderer), QQuickWindow::NoStage);
+    } else {
+        delete m_renderer;
+    }
+}
+
+void ImGuiQuickItem::paintImGui()
+{
+}
+
+void ImGuiQuickItem::updatePolish()
+{
+    if (width() <= 0 || height() <= 0)
+        return;
+
+    m_renderer->newFrame();
+    paintImGui();
+    ImGui::Render();
+
+    // Nothing else renders this context's draw data, take its buffers instead of copying them
+    if (m_pending)
+        m_renderer->releaseSnapshot(m_pending);
+    m_pending = m_renderer->takeSnapshot(nullptr, DrawDataSnapshot::Swap);
+}
+
+QSGNode *ImGuiQuickItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data);
+
+    auto *node = static_cast<ImGuiQuickNode*>(oldNode);
+    if (!node) {
+        if (window()->rendererInterface()->graphicsApi() != QSGRendererInterface::OpenGL) {
+            qWarning("QtImGui: ImGuiQuickItem needs the OpenGL scene graph backend");
+            return nullptr;
+        }
+        node = new ImGuiQuickNode(m_renderer);
+    }
+
+    // The scene graph context is current and the GUI thread is blocked, device objects
+    // can be created from the ImGui font atlas here. Only does something on a new context.
+    m_renderer->initializeGL();
+
+    node->sync(m_pending, QSizeF(width(), height()), window()->height(), window()->effectiveDevicePixelRatio());
+    m_pending = nullptr;
+    node->markDirty(QSGNode::DirtyMaterial);
+    return node;
+}
+
+void ImGuiQuickItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    if (change == ItemSceneChange) {
+        disconnect(m_frameSwapped);
+        disconnect(m_sceneGraphInvalidated);
+        if (value.window) {
+            // Build the next frame as soon as the previous one is on screen. frameSwapped is
+            // emitted on the render thread, the queued connection brings us to the GUI thread.
+            m_frameSwapped = connect(value.window, &QQuickWindow::frameSwapped,
+                                     this, &ImGuiQuickItem::scheduleFrame, Qt::QueuedConnection);
+            // Emitted on the render thread with the scene graph context current, the only
+            // place its GL objects can be deleted. updatePaintNode() creates them again.
+            ImGuiRenderer *renderer = m_renderer;
+            m_sceneGraphInvalidated = connect(value.window, &QQuickWindow::sceneGraphInvalidated,
+                                              renderer, [renderer]() { renderer->releaseGL(); }, Qt::DirectConnection);
+            scheduleFrame();
+        }
+    } else if (change == ItemVisibleHasChanged) {
+        scheduleFrame();
+    }
+    QQuickItem::itemChange(change, value);
+}
+
+void ImGuiQuickItem::scheduleFrame()
+{
+    if (isVisible()) {
+        polish();
+        update();
+    }
+}
+
+void ImGuiQuickItem::mousePressEvent(QMouseEvent *event)
+{
+    forceActiveFocus(Qt::MouseFocusReason);
+    event->accept();
+}
+
+void ImGuiQuickItem::mouseMoveEvent(QMouseEvent *event)
+{
+    event->accept();
+}
+
+void ImGuiQuickItem::mouseReleaseEvent(QMouseEvent *event)
+{
+    event->accept();
+}
+
+void ImGuiQuickItem::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    event->accept();
+}
+
+void ImGuiQuickItem::wheelEvent(QWheelEvent *event)
+{
+    event->accept();
+}
+
+void ImGuiQuickItem::keyPressEvent(QKeyEvent *event)
+{
+    event->accept();
+}
+
+void ImGuiQuickItem::keyReleaseEvent(QKeyEvent *event)
+{
+    event->accept();
+}
+
+} // namespace QtImGui
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QQuickItem>
+
+namespace QtImGui {
+
+class DrawDataSnapshot;
+class ImGuiRenderer;
+
+// Qt Quick item drawing an ImGui context in the scene graph.
+//
+// Subclass it, build the UI in paintImGui() and register the type with qmlRegisterType().
+// The UI is built on the GUI thread during polish. The draw data is snapshotted there and
+// only handed over to the scene graph in updatePaintNode(), so the Quick render thread
+// submits frame N while the GUI thread is free to build frame N+1.
+//
+// Needs the OpenGL scene graph backend. The item redraws continuously while visible.
+class ImGuiQuickItem : public QQuickItem {
+    Q_OBJECT
+public:
+    explicit ImGuiQuickItem(QQuickItem *parent = nullptr);
+    ~ImGuiQuickItem();
+
+    ImGuiRenderer *renderer() const { return m_renderer; }
+
+protected:
+    // Called on the GUI thread with the item's ImGui context current, between
+    // ImGui::NewFrame() and ImGui::Render()
+    virtual void paintImGui();
+
+    void updatePolish() override;
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+    // Accept input so that the moves and releases following a press are delivered here,
+    // the renderer reads them through its event filter
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void keyReleaseEvent(QKeyEvent *event) override;
+
+private:
+    void scheduleFrame();
+
+    ImGuiRenderer *m_renderer;
+    DrawDataSnapshot *m_pending = nullptr;   // Built by updatePolish(), taken by updatePaintNode()
+    QMetaObject::Connection m_frameSwapped;
+    QMetaObject::Connection m_sceneGraphInvalidated;
+};
+
+} // namespace QtImGui
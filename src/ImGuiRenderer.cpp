@@ -1,10 +1,24 @@
 #include "ImGuiRenderer.h"
 
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QGuiApplication>
 #include <QMouseEvent>
 #include <QClipboard>
 #include <QCursor>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QThread>
+#include <QWindow>
+#include <cstring>
+#include "PainterRenderer.h"
+#include "ImGuiAllocator.h"
+#include "SoftwareRasterizer.h"
+#include "Trace.h"
+#ifdef QTIMGUI_HAS_RHI
+#include "RhiRenderer.h"
+#endif
 
 #ifdef ANDROID
 #define GL_VERTEX_ARRAY_BINDING           0x85B5 // Missing in android as of May 2020
@@ -64,13 +78,65 @@ const QHash<ImGuiMouseCursor, Qt::CursorShape> cursorMap = {
 
 QByteArray g_currentClipboardText;
 
+// Live renderers, see ImGuiRenderer::renderers()
+QMutex g_renderersMutex;
+QList<ImGuiRenderer*> g_renderers;
+int g_lastRendererId = 0;
+
 } // namespace
 
 void ImGuiRenderer::initialize(WindowWrapper *window) {
+    initialize(window, InitOptions());
+}
+
+void ImGuiRenderer::initialize(WindowWrapper *window, const InitOptions &options) {
     m_window.reset(window);
-    initializeOpenGLFunctions();
 
-    g_ctx = ImGui::CreateContext();
+    QWindow *renderWindow = nullptr;
+    if (options.threadedRendering) {
+        renderWindow = qobject_cast<QWindow*>(window->object());
+        if (!renderWindow)
+            qWarning("QtImGui: threaded rendering needs a QWindow, rendering on the calling thread");
+    }
+
+    if (options.backend == Backend::Rhi) {
+#ifdef QTIMGUI_HAS_RHI
+        if (QWindow *rhiWindow = qobject_cast<QWindow*>(window->object()))
+            m_backend.reset(new RhiRenderer(rhiWindow, options.rhiApi));
+        else
+            qWarning("QtImGui: the QRhi backend needs a QWindow, using OpenGL");
+#else
+        qWarning("QtImGui: built without QRhi support, using OpenGL");
+#endif
+        renderWindow = nullptr;
+    } else if (options.backend == Backend::Software) {
+        // Without a QWindow (e.g. a QWidget host) frames are only rendered to image()
+        m_backend.reset(new SoftwareRasterizer(qobject_cast<QWindow*>(window->object()), options.softwareThreads));
+        renderWindow = nullptr;
+    } else if (options.backend == Backend::Painter) {
+        // QWidget is both a QObject and a QPaintDevice, a QWindow cannot be painted on
+        if (QPaintDevice *device = dynamic_cast<QPaintDevice*>(window->object()))
+            m_backend.reset(new PainterRenderer(window->object(), device));
+        else
+            qWarning("QtImGui: the QPainter backend needs a QWidget, using OpenGL");
+        renderWindow = nullptr;
+    }
+
+    // With a render thread, GL functions are resolved there
+    m_deferredGL = renderWindow || options.externalRendering || m_backend;
+    if (!m_deferredGL)
+        initializeOpenGLFunctions();
+
+    // The context itself is allocated before it can be attached to its heap
+    const bool tracking = options.trackAllocations || options.allocator != AllocatorPolicy::Malloc;
+    if (tracking && Allocator::install())
+        m_heap = Allocator::newHeap(options.allocator);
+    {
+        Allocator::ScopedOwner owner(m_heap);
+        g_ctx = ImGui::CreateContext();
+    }
+    if (m_heap)
+        Allocator::attach(g_ctx, m_heap);
     ImGui::SetCurrentContext(g_ctx);
 
     // Setup backend capabilities flags
@@ -100,20 +166,166 @@ void ImGuiRenderer::initialize(WindowWrapper *window) {
     };
 
     window->installEventFilter(this);
+
+    if (renderWindow) {
+        m_renderThread.reset(new RenderThread(this, renderWindow));
+        m_renderThread->startRendering();
+    }
 }
 
-void ImGuiRenderer::renderDrawList(ImDrawData *draw_data)
+void ImGuiRenderer::initializeOffscreen(WindowWrapper *window, const InitOptions &options) {
+    InitOptions offscreenOptions = options;
+    offscreenOptions.threadedRendering = false;
+    offscreenOptions.externalRendering = false;
+    if (options.backend != Backend::OpenGL && options.backend != Backend::Software) {
+        qWarning("QtImGui: offscreen rendering supports the OpenGL and software backends, using software");
+        offscreenOptions.backend = Backend::Software;
+    }
+
+    // The context stays current for initialize() to resolve GL functions
+    if (offscreenOptions.backend == Backend::OpenGL) {
+        m_offscreen.reset(new OffscreenTarget());
+        if (!m_offscreen->create()) {
+            qWarning("QtImGui: no offscreen OpenGL context, using software");
+            m_offscreen.reset();
+            offscreenOptions.backend = Backend::Software;
+        }
+    }
+
+    initialize(window, offscreenOptions);
+
+    // Frames are rendered back to back, wall time between them means nothing
+    setFixedDeltaTime(1.0f / 60.0f);
+}
+
+namespace {
+thread_local const RenderCallbackContext *t_callbackContext = nullptr;
+} // namespace
+
+const RenderCallbackContext *ImGuiRenderer::callbackContext()
 {
-    // Select current context
-    ImGui::SetCurrentContext(g_ctx);
+    return t_callbackContext;
+}
+
+void ImGuiRenderer::setupRenderState(const RenderCallbackContext &ctx)
+{
+    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled
+    // No glGet here, this runs again after every user callback
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+    glActiveTexture(GL_TEXTURE0);
+
+    glViewport(ctx.framebufferX, ctx.framebufferY, (GLsizei)ctx.framebufferWidth, (GLsizei)ctx.framebufferHeight);
+    glUseProgram(g_ShaderHandle);
+    glUniform1i(g_AttribLocationTex, 0);
+    glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ctx.projection[0][0]);
+    glBindVertexArray(g_VaoHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
+}
+
+void ImGuiRenderer::setVertexOffset(const char *offset)
+{
+    // Vertex attribute pointers of the bound VAO, for vertices at `offset` in the VBO
+#define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
+    glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)(offset + OFFSETOF(ImDrawVert, pos)));
+    glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)(offset + OFFSETOF(ImDrawVert, uv)));
+    glVertexAttribPointer(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)(offset + OFFSETOF(ImDrawVert, col)));
+#undef OFFSETOF
+}
+
+void ImGuiRenderer::initializeGL()
+{
+    // Integrations call it again for each frame or after their context was recreated
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (context && context == m_glContext)
+        return;
+
+    // Objects of a previous context that is still alive
+    releaseDeviceObjects();
+    initializeOpenGLFunctions();
+    createDeviceObjects();
+}
+
+void ImGuiRenderer::renderDrawData(ImDrawData *drawData, const QPoint &framebufferOffset)
+{
+    renderDrawList(drawData, framebufferOffset);
+}
 
+void ImGuiRenderer::renderDrawList(ImDrawData *draw_data, const QPoint &fb_offset)
+{
     // Avoid rendering when minimized, scale coordinates for retina displays (screen coordinates != framebuffer coordinates)
-    const ImGuiIO& io = ImGui::GetIO();
-    int fb_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
-    int fb_height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
-    if (fb_width == 0 || fb_height == 0)
+    // Only draw_data is used from here on, it may be a copy rendered outside of the ImGui context
+    int fb_width = (int)(draw_data->DisplaySize.x * draw_data->FramebufferScale.x);
+    int fb_height = (int)(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+    if (fb_width <= 0 || fb_height <= 0)
+        return;
+
+    // Released with a lost context and not created again yet
+    if (!m_glContext)
         return;
-    draw_data->ScaleClipRects(io.DisplayFramebufferScale);
+
+    QTIMGUI_ZONE("QtImGui renderDrawList");
+    QElapsedTimer pass_timer;
+    pass_timer.start();
+
+    if (m_gpuTiming && !m_gpuTimerResolved) {
+        m_gpuTimerResolved = true;
+        if (!m_gpuTimer.initialize(this, &m_glResources))
+            qWarning("QtImGui: GPU timing needs timer queries (GL 3.3, ARB_timer_query or EXT_disjoint_timer_query)");
+    }
+    if (m_glDebugging != m_glDebugActive)
+        updateGlDebug();
+    const bool gl_debug = m_glDebugActive;
+    if (gl_debug)
+        m_glDebug.pushGroup("QtImGui");
+
+    const bool gpu_timing = m_gpuTiming && m_gpuTimer.isAvailable();
+    const bool gpu_collected = gpu_timing && m_gpuTimer.collect();
+    if (gpu_timing)
+        m_gpuTimer.beginPass(draw_data);
+
+    // All lists of the pass share one VBO and IBO, orphaned once per pass with the same
+    // size so drivers can recycle the storage. Capacity left by a spike is trimmed.
+    qint64 vtx_total = 0, idx_total = 0;
+    for (int n = 0; n < draw_data->CmdListsCount; n++) {
+        vtx_total += qint64(draw_data->CmdLists[n]->VtxBuffer.Size) * qint64(sizeof(ImDrawVert));
+        idx_total += qint64(draw_data->CmdLists[n]->IdxBuffer.Size) * qint64(sizeof(ImDrawIdx));
+    }
+    const TrimOptions trim_options = trimOptions();
+    const qint64 vbo_capacity = m_vboHighWater.update(vtx_total, m_vboCapacity, trim_options);
+    const qint64 ibo_capacity = m_iboHighWater.update(idx_total, m_iboCapacity, trim_options);
+    const int gpu_trims = (vbo_capacity < m_vboCapacity ? 1 : 0) + (ibo_capacity < m_iboCapacity ? 1 : 0);
+    const qint64 gpu_released = qMax(qint64(0), m_vboCapacity - vbo_capacity) + qMax(qint64(0), m_iboCapacity - ibo_capacity);
+    m_glCounters.bufferReallocations += (vbo_capacity != m_vboCapacity ? 1 : 0) + (ibo_capacity != m_iboCapacity ? 1 : 0);
+    m_vboCapacity = vbo_capacity;
+    m_iboCapacity = ibo_capacity;
+
+    // Orthographic projection covering the draw data display rect
+    RenderCallbackContext ctx;
+    ctx.renderer = this;
+    ctx.drawData = draw_data;
+    ctx.framebufferScale = draw_data->FramebufferScale;
+    ctx.framebufferX = fb_offset.x();
+    ctx.framebufferY = fb_offset.y();
+    ctx.framebufferWidth = fb_width;
+    ctx.framebufferHeight = fb_height;
+    const float L = draw_data->DisplayPos.x;
+    const float R = draw_data->DisplayPos.x + draw_data->DisplaySize.x;
+    const float T = draw_data->DisplayPos.y;
+    const float B = draw_data->DisplayPos.y + draw_data->DisplaySize.y;
+    const float ortho_projection[4][4] =
+    {
+        { 2.0f/(R-L),   0.0f,         0.0f, 0.0f },
+        { 0.0f,         2.0f/(T-B),   0.0f, 0.0f },
+        { 0.0f,         0.0f,        -1.0f, 0.0f },
+        { (R+L)/(L-R),  (T+B)/(B-T),  0.0f, 1.0f },
+    };
+    memcpy(ctx.projection, ortho_projection, sizeof(ortho_projection));
 
     // Backup GL state
     GLint last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, &last_active_texture);
@@ -136,55 +348,84 @@ void ImGuiRenderer::renderDrawList(ImDrawData *draw_data)
     GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
     GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
 
-    // Setup render state: alpha-blending enabled, no face culling, no depth testing, scissor enabled
-    glEnable(GL_BLEND);
-    glBlendEquation(GL_FUNC_ADD);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_SCISSOR_TEST);
+    setupRenderState(ctx);
 
-    // Setup viewport, orthographic projection matrix
-    glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
-    const float ortho_projection[4][4] =
     {
-        { 2.0f/io.DisplaySize.x, 0.0f,                   0.0f, 0.0f },
-        { 0.0f,                  2.0f/-io.DisplaySize.y, 0.0f, 0.0f },
-        { 0.0f,                  0.0f,                  -1.0f, 0.0f },
-        {-1.0f,                  1.0f,                   0.0f, 1.0f },
-    };
-    glUseProgram(g_ShaderHandle);
-    glUniform1i(g_AttribLocationTex, 0);
-    glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
-    glBindVertexArray(g_VaoHandle);
+        QTIMGUI_ZONE("QtImGui upload");
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)m_vboCapacity, nullptr, GL_STREAM_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)m_iboCapacity, nullptr, GL_STREAM_DRAW);
+        GLintptr vtx_offset = 0, idx_offset = 0;
+        for (int n = 0; n < draw_data->CmdListsCount; n++) {
+            const ImDrawList* cmd_list = draw_data->CmdLists[n];
+            const GLsizeiptr vtx_size = (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+            const GLsizeiptr idx_size = (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+            glBufferSubData(GL_ARRAY_BUFFER, vtx_offset, vtx_size, (const GLvoid*)cmd_list->VtxBuffer.Data);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, idx_offset, idx_size, (const GLvoid*)cmd_list->IdxBuffer.Data);
+            vtx_offset += vtx_size;
+            idx_offset += idx_size;
+        }
+    }
+
+    // Project scissor/clipping rectangles into framebuffer space
+    const ImVec2 clip_off = draw_data->DisplayPos;
+    const ImVec2 clip_scale = draw_data->FramebufferScale;
 
+    // User callbacks can query the context through ImGuiRenderer::callbackContext()
+    const RenderCallbackContext *last_callback_context = t_callbackContext;
+    t_callbackContext = &ctx;
+
+    // Indices are relative to their list, its vertices are selected by the attribute
+    // offsets rather than a base vertex, which GL ES 3.0 lacks
+    const char* vtx_buffer_offset = 0;
+    const ImDrawIdx* idx_buffer_offset = 0;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawIdx* idx_buffer_offset = 0;
-
-        glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
+        if (gl_debug)
+            m_glDebug.pushGroup(cmd_list->_OwnerName ? cmd_list->_OwnerName : "ImDrawList");
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+        QTIMGUI_ZONE("QtImGui draw");
+        setVertexOffset(vtx_buffer_offset);
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
             const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
             if (pcmd->UserCallback)
             {
-                pcmd->UserCallback(cmd_list, pcmd);
+                // ImDrawCallback_ResetRenderState is a special value, not a function to call
+                if (pcmd->UserCallback != ImDrawCallback_ResetRenderState)
+                    pcmd->UserCallback(cmd_list, pcmd);
+
+                // Callbacks may issue any GL call, re-apply our state (without querying anything)
+                setupRenderState(ctx);
             }
             else
             {
-                glBindTexture(GL_TEXTURE_2D, (GLuint)(size_t)pcmd->TextureId);
-                glScissor((int)pcmd->ClipRect.x, (int)(fb_height - pcmd->ClipRect.w), (int)(pcmd->ClipRect.z - pcmd->ClipRect.x), (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
-                glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idx_buffer_offset);
+                ImVec4 clip_rect;
+                clip_rect.x = (pcmd->ClipRect.x - clip_off.x) * clip_scale.x;
+                clip_rect.y = (pcmd->ClipRect.y - clip_off.y) * clip_scale.y;
+                clip_rect.z = (pcmd->ClipRect.z - clip_off.x) * clip_scale.x;
+                clip_rect.w = (pcmd->ClipRect.w - clip_off.y) * clip_scale.y;
+
+                if (clip_rect.x < fb_width && clip_rect.y < fb_height && clip_rect.z >= 0.0f && clip_rect.w >= 0.0f)
+                {
+                    glBindTexture(GL_TEXTURE_2D, (GLuint)(size_t)pcmd->TextureId);
+                    glScissor(fb_offset.x() + (int)clip_rect.x, fb_offset.y() + (int)(fb_height - clip_rect.w), (int)(clip_rect.z - clip_rect.x), (int)(clip_rect.w - clip_rect.y));
+                    glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idx_buffer_offset);
+                }
             }
             idx_buffer_offset += pcmd->ElemCount;
         }
+        vtx_buffer_offset += cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+        if (gpu_timing)
+            m_gpuTimer.endList(n);
+        if (gl_debug)
+            m_glDebug.popGroup();
     }
+    if (gpu_timing)
+        m_gpuTimer.endPass();
+
+    t_callbackContext = last_callback_context;
 
     // Restore modified GL state
     glUseProgram(last_program);
@@ -201,6 +442,152 @@ void ImGuiRenderer::renderDrawList(ImDrawData *draw_data)
     if (last_enable_scissor_test) glEnable(GL_SCISSOR_TEST); else glDisable(GL_SCISSOR_TEST);
     glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
     glScissor(last_scissor_box[0], last_scissor_box[1], (GLsizei)last_scissor_box[2], (GLsizei)last_scissor_box[3]);
+
+    if (gl_debug)
+        m_glDebug.popGroup();
+
+    m_glCounters.cpuMs = pass_timer.nsecsElapsed() / 1e6;
+    m_glCounters.gpuMs = gpu_timing ? m_gpuTimer.passMs() : -1.0;
+    QMutexLocker lock(&m_statsMutex);
+    m_frameStats = m_glCounters;
+    m_totalStats.add(m_glCounters);
+    // Reset after the pass rather than before, so that the font atlas and other device
+    // objects created between passes are counted in the next one
+    m_glCounters = FrameStats();
+    m_trimStats.gpuCapacityBytes = m_vboCapacity + m_iboCapacity;
+    m_trimStats.gpuHighWaterBytes = m_vboHighWater.highWater() + m_iboHighWater.highWater();
+    m_trimStats.gpuTrims += quint64(gpu_trims);
+    m_trimStats.gpuBytesReleased += gpu_released;
+    if (gpu_collected)
+        m_listGpuTimes = m_gpuTimer.lists();
+    lock.unlock();
+    if (gpu_collected && m_windowCostTracking)
+        m_windowCostTracker.addGpuTimes(m_gpuTimer.lists());
+}
+
+void ImGuiRenderer::updateGlDebug()
+{
+    if (!m_glDebugResolved) {
+        m_glDebugResolved = true;
+        if (!m_glDebug.initialize())
+            qWarning("QtImGui: GL debugging needs GL 4.3, GLES 3.2 or KHR_debug");
+    }
+    if (!m_glDebug.isAvailable()) {
+        m_glDebugging = false;
+        return;
+    }
+
+    m_glDebugActive = m_glDebugging;
+    m_glDebug.setLogging(m_glDebugActive);
+    if (m_glDebugActive) {
+        m_glDebug.label(GL_PROGRAM, g_ShaderHandle, "QtImGui program");
+        m_glDebug.label(GL_SHADER, g_VertHandle, "QtImGui vertex shader");
+        m_glDebug.label(GL_SHADER, g_FragHandle, "QtImGui fragment shader");
+        m_glDebug.label(GL_BUFFER, g_VboHandle, "QtImGui vertices");
+        m_glDebug.label(GL_BUFFER, g_ElementsHandle, "QtImGui indices");
+        m_glDebug.label(GL_VERTEX_ARRAY, g_VaoHandle, "QtImGui VAO");
+        m_glDebug.label(GL_TEXTURE, g_FontTexture, "QtImGui font atlas");
+    }
+}
+
+std::vector<ListGpuTime> ImGuiRenderer::listGpuTimes() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_listGpuTimes;
+}
+
+FrameStats ImGuiRenderer::frameStats() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_frameStats;
+}
+
+FrameTotals ImGuiRenderer::totalStats() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_totalStats;
+}
+
+void ImGuiRenderer::setTrimOptions(const TrimOptions &options)
+{
+    QMutexLocker lock(&m_statsMutex);
+    m_trimOptions = options;
+}
+
+TrimOptions ImGuiRenderer::trimOptions() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_trimOptions;
+}
+
+TrimStats ImGuiRenderer::trimStats() const
+{
+    QMutexLocker lock(&m_statsMutex);
+    return m_trimStats;
+}
+
+void ImGuiRenderer::registerTexture(ImTextureID texture, qint64 bytes)
+{
+    QMutexLocker lock(&m_statsMutex);
+    m_userTextures.insert(texture, bytes);
+}
+
+void ImGuiRenderer::unregisterTexture(ImTextureID texture)
+{
+    QMutexLocker lock(&m_statsMutex);
+    m_userTextures.remove(texture);
+}
+
+MemoryStats ImGuiRenderer::memoryStats() const
+{
+    MemoryStats memory;
+    memory.fontTextureBytes = m_fontTextureBytes;
+    memory.viewportFboBytes = m_viewports.stats().bytes;
+    memory.offscreenFboBytes = m_offscreen ? m_offscreen->bytes() : 0;
+    memory.recorderBytes = m_recorder ? m_recorder->bufferBytes() : 0;
+    memory.heapBytes = allocatorStats().reservedBytes;
+    memory.snapshotBytes = m_snapshots.capacityBytes();
+
+    QMutexLocker lock(&m_statsMutex);
+    for (qint64 bytes : m_userTextures)
+        memory.userTextureBytes += bytes;
+    memory.userTextures = m_userTextures.size();
+    memory.bufferBytes = m_trimStats.gpuCapacityBytes;
+    memory.drawListBytes = m_trimStats.cpuCapacityBytes;
+    return memory;
+}
+
+MemoryStats ImGuiRenderer::totalMemoryStats()
+{
+    MemoryStats total;
+    for (const ImGuiRenderer *renderer : renderers())
+        total += renderer->memoryStats();
+    total.heapBytes += Allocator::unattributed()->heapStats().reservedBytes;
+    return total;
+}
+
+void ImGuiRenderer::trimDrawListBuffers()
+{
+    // Between frames, the draw lists still hold the last frame
+    const TrimOptions options = trimOptions();
+    const DrawListMemory memory = drawListMemory(g_ctx);
+    qint64 released = 0;
+    if (m_drawListHighWater.update(memory.usedBytes, memory.capacityBytes, options) < memory.capacityBytes) {
+        QTIMGUI_ZONE("QtImGui trim");
+        released = trimDrawLists(g_ctx, options);
+        // The allocator may cache what the lists gave back
+        if (released > 0 && m_heap)
+            m_heap->trim();
+    }
+
+    QMutexLocker lock(&m_statsMutex);
+    m_trimStats.cpuCapacityBytes = memory.capacityBytes - released;
+    m_trimStats.cpuUsedBytes = memory.usedBytes;
+    m_trimStats.cpuHighWaterBytes = m_drawListHighWater.highWater();
+    if (released > 0) {
+        m_trimStats.cpuTrims++;
+        m_trimStats.cpuBytesReleased += released;
+    }
 }
 
 bool ImGuiRenderer::createFontsTexture()
@@ -218,6 +605,7 @@ bool ImGuiRenderer::createFontsTexture()
     GLint last_texture;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
     glGenTextures(1, &g_FontTexture);
+    m_glResources.created();
     glBindTexture(GL_TEXTURE_2D, g_FontTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -225,6 +613,7 @@ bool ImGuiRenderer::createFontsTexture()
 
     // Store our identifier
     io.Fonts->TexID = (void *)(size_t)g_FontTexture;
+    m_fontTextureBytes = qint64(width) * height * 4;
 
     // Restore state
     glBindTexture(GL_TEXTURE_2D, last_texture);
@@ -237,6 +626,11 @@ bool ImGuiRenderer::createDeviceObjects()
     // Select current context
     ImGui::SetCurrentContext(g_ctx);
 
+    // Direct: the context is usually current while the signal is emitted, on its own thread
+    m_glContext = QOpenGLContext::currentContext();
+    m_glContextDestroyed = connect(m_glContext, &QOpenGLContext::aboutToBeDestroyed,
+                                   this, [this]() { releaseDeviceObjects(); }, Qt::DirectConnection);
+
     // Backup GL state
     GLint last_texture, last_array_buffer, last_vertex_array;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
@@ -291,17 +685,13 @@ bool ImGuiRenderer::createDeviceObjects()
     glGenBuffers(1, &g_ElementsHandle);
 
     glGenVertexArrays(1, &g_VaoHandle);
+    m_glResources.created(6);   // Program, shaders, buffers and VAO
     glBindVertexArray(g_VaoHandle);
     glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
     glEnableVertexAttribArray(g_AttribLocationPosition);
     glEnableVertexAttribArray(g_AttribLocationUV);
     glEnableVertexAttribArray(g_AttribLocationColor);
-
-#define OFFSETOF(TYPE, ELEMENT) ((size_t)&(((TYPE *)0)->ELEMENT))
-    glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, pos));
-    glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, uv));
-    glVertexAttribPointer(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)OFFSETOF(ImDrawVert, col));
-#undef OFFSETOF
+    setVertexOffset(nullptr);
 
     createFontsTexture();
 
@@ -313,13 +703,129 @@ bool ImGuiRenderer::createDeviceObjects()
     return true;
 }
 
+void ImGuiRenderer::releaseDeviceObjects()
+{
+    QOpenGLContext *context = m_glContext;
+    if (!context)
+        return;
+    disconnect(m_glContextDestroyed);
+
+    // Objects can only be deleted on their context. When it is not current, it can be made
+    // current on a temporary surface from its own thread, if that is the GUI thread.
+    QOpenGLContext *previous = QOpenGLContext::currentContext();
+    QSurface *previous_surface = previous ? previous->surface() : nullptr;
+    bool current = previous == context;
+    std::unique_ptr<QOffscreenSurface> surface;
+    if (!current && context->thread() == QThread::currentThread() && QThread::currentThread() == qApp->thread()) {
+        surface.reset(new QOffscreenSurface());
+        surface->setFormat(context->format());
+        surface->create();
+        current = surface->isValid() && context->makeCurrent(surface.get());
+    }
+    if (!current)
+        qWarning("QtImGui: releasing the GL objects of a context that cannot be made current, they leak");
+
+    destroyDeviceObjects(current);
+    m_glContext = nullptr;
+
+    if (surface && current) {
+        if (previous && previous_surface)
+            previous->makeCurrent(previous_surface);
+        else
+            context->doneCurrent();
+    }
+}
+
+void ImGuiRenderer::destroyDeviceObjects(bool contextCurrent)
+{
+    const int objects = (g_ShaderHandle ? 1 : 0) + (g_VertHandle ? 1 : 0) + (g_FragHandle ? 1 : 0)
+                      + (g_VboHandle ? 1 : 0) + (g_ElementsHandle ? 1 : 0) + (g_VaoHandle ? 1 : 0)
+                      + (g_FontTexture ? 1 : 0);
+    if (contextCurrent) {
+        // Zero names are ignored; attached shaders go with their program
+        glDeleteVertexArrays(1, &g_VaoHandle);
+        glDeleteBuffers(1, &g_VboHandle);
+        glDeleteBuffers(1, &g_ElementsHandle);
+        glDeleteShader(GLuint(g_VertHandle));
+        glDeleteShader(GLuint(g_FragHandle));
+        glDeleteProgram(GLuint(g_ShaderHandle));
+        glDeleteTextures(1, &g_FontTexture);
+        m_glResources.deleted(objects);
+        m_gpuTimer.release();
+    } else {
+        m_glResources.leaked(objects);
+        m_gpuTimer.forget();
+    }
+
+    // Viewport FBOs and the recorder's buffers belong to the same context
+    m_viewports.clear();
+    if (m_recorder) {
+        if (contextCurrent)
+            m_recorder->finish();
+        m_lastRecordingStats = m_recorder->stats();
+        m_recorder.reset();
+        m_recordingRequested = false;
+        qWarning("QtImGui: recording stopped, its GL context went away");
+    }
+    m_glDebug.release();
+
+    g_ShaderHandle = g_VertHandle = g_FragHandle = 0;
+    g_VboHandle = g_ElementsHandle = g_VaoHandle = 0;
+    g_FontTexture = 0;
+    m_fontTextureBytes = 0;
+    m_gpuTimerResolved = false;
+    m_glDebugResolved = false;
+    m_glDebugActive = false;
+    m_vboCapacity = 0;
+    m_iboCapacity = 0;
+
+    QMutexLocker lock(&m_statsMutex);
+    m_trimStats.gpuCapacityBytes = 0;
+}
+
 void ImGuiRenderer::newFrame()
 {
+    if (!m_phaseClock.isValid())
+        m_phaseClock.start();
+    const qint64 new_frame_start = m_phaseClock.nsecsElapsed();
+    QTIMGUI_ZONE("QtImGui newFrame");
+    if (m_heap)
+        m_heap->frameBoundary();
+    const AllocationStats allocations_start = allocationStats();
+
     // Select current context
     ImGui::SetCurrentContext(g_ctx);
 
-    if (!g_FontTexture)
-        createDeviceObjects();
+    // Several offscreen renderers may share the thread
+    if (m_offscreen)
+        m_offscreen->makeCurrent();
+
+    if (m_backend) {
+        // A backend that failed to set up draws nothing, it is not retried every frame
+        if (!m_backendCreated) {
+            m_backendCreated = true;
+            m_backendReady = m_backend->createDeviceObjects();
+            if (!m_backendReady)
+                qWarning("QtImGui: the render backend could not be set up, frames will not be drawn");
+        }
+    } else if (!m_deferredGL) {
+        // First frame, or the previous context was destroyed: objects go to the current one
+        if (!m_glContext && QOpenGLContext::currentContext())
+            initializeGL();
+    } else {
+        // Device objects are created on the GL thread, ImGui::NewFrame() only needs a built
+        // atlas. Returns at once once it is built.
+        unsigned char* pixels;
+        int width, height;
+        ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    }
+
+    // FBOs of viewports that were not drawn last frame go back to the pool
+    m_viewports.endFrame();
+
+    m_snapshotAllocations = m_snapshots.takeAllocationCount();
+
+    trimDrawListBuffers();
 
     ImGuiIO& io = ImGui::GetIO();
 
@@ -329,7 +835,8 @@ void ImGuiRenderer::newFrame()
 
     // Setup time step
     double current_time =  QDateTime::currentMSecsSinceEpoch() / double(1000);
-    io.DeltaTime = g_Time > 0.0 ? (float)(current_time - g_Time) : (float)(1.0f/60.0f);
+    io.DeltaTime = m_fixedDeltaTime > 0.0f ? m_fixedDeltaTime
+                 : g_Time > 0.0 ? (float)(current_time - g_Time) : (float)(1.0f/60.0f);
     g_Time = current_time;
     
     
@@ -365,26 +872,266 @@ void ImGuiRenderer::newFrame()
 
     // Start the frame
     ImGui::NewFrame();
+
+    m_newFrameEnd = m_phaseClock.nsecsElapsed();
+    m_newFrameMs = float((m_newFrameEnd - new_frame_start) / 1e6);
+    m_newFrameEndAllocations = allocationStats();
+    m_phaseAllocations[FrameTimings::NewFrame] = m_newFrameEndAllocations - allocations_start;
 }
 
-void ImGuiRenderer::render()
+void ImGuiRenderer::render(ImDrawData *drawData)
 {
+  if (!m_phaseClock.isValid())
+    m_phaseClock.start();
+  const qint64 render_start = m_phaseClock.nsecsElapsed();
+  QTIMGUI_ZONE("QtImGui render");
+  const AllocationStats allocations_start = allocationStats();
+
   // Select current context
   ImGui::SetCurrentContext(g_ctx);
 
-  auto drawData = ImGui::GetDrawData();
-  renderDrawList(drawData);
+  if (!drawData)
+    drawData = ImGui::GetDrawData();
+  if (m_drawDataWriter)
+    m_drawDataWriter->write(drawData);
+  // A render thread swaps the buffers of drawData's lists for those of an older frame
+  if (m_windowCostTracking)
+    m_windowCostTracker.addFrame(drawData);
+  m_frameBudget.capture(drawData, !m_backend && !m_offscreen && m_renderThread);
+
+  if (m_backend) {
+    if (m_backendReady)
+      m_backend->render(drawData, m_clearColor);
+  } else if (m_offscreen) {
+    const QSize pixelSize(qMax(1, (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x)),
+                          qMax(1, (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y)));
+    if (m_offscreen->bind(pixelSize)) {
+      glViewport(0, 0, pixelSize.width(), pixelSize.height());
+      glClearColor(m_clearColor.x, m_clearColor.y, m_clearColor.z, m_clearColor.w);
+      glClear(GL_COLOR_BUFFER_BIT);
+      renderDrawList(drawData, QPoint());
+      updateRecording(drawData);
+    }
+  } else if (m_renderThread) {
+    m_renderThread->submit(drawData, m_clearColor);
+  } else if (!m_deferredGL) {
+    renderDrawList(drawData, QPoint());
+    updateRecording(drawData);
+  }
+
+  // Draw data rendered without newFrame() (replays) only has a render phase
+  const qint64 render_end = m_phaseClock.nsecsElapsed();
+  if (m_windowCostTracking) {
+    if (render_end - m_windowCostsReported >= 1000000000) {
+      m_windowCostsReported = render_end;
+      m_windowCosts = m_windowCostTracker.take();
+      emit windowCostsUpdated(m_windowCosts);
+    }
+  }
+  const bool in_frame = m_newFrameEnd >= 0;
+  const float new_frame_ms = in_frame ? m_newFrameMs : 0.0f;
+  const float build_ms = in_frame ? float((render_start - m_newFrameEnd) / 1e6) : 0.0f;
+  const float render_ms = float((render_end - render_start) / 1e6);
+  m_frameTimings.addFrame(new_frame_ms, build_ms, render_ms);
+
+  const AllocationStats allocations_end = allocationStats();
+  if (!in_frame)
+    m_phaseAllocations[FrameTimings::NewFrame] = AllocationStats();
+  m_phaseAllocations[FrameTimings::Build] = in_frame ? allocations_start - m_newFrameEndAllocations : AllocationStats();
+  m_phaseAllocations[FrameTimings::Render] = allocations_end - allocations_start;
+  m_frameAllocations = allocations_end - m_frameEndAllocations;
+  m_frameEndAllocations = allocations_end;
+  if (m_zeroAllocationFrame >= 0 && m_frameIndex >= quint64(m_zeroAllocationFrame) && m_frameAllocations.allocations > 0) {
+    qFatal("QtImGui: frame %llu made %llu ImGui allocations (%llu bytes) after warm-up; newFrame %llu, build %llu, render %llu",
+           (unsigned long long)m_frameIndex, (unsigned long long)m_frameAllocations.allocations,
+           (unsigned long long)m_frameAllocations.bytesAllocated,
+           (unsigned long long)m_phaseAllocations[FrameTimings::NewFrame].allocations,
+           (unsigned long long)m_phaseAllocations[FrameTimings::Build].allocations,
+           (unsigned long long)m_phaseAllocations[FrameTimings::Render].allocations);
+  }
+  if (m_frameBudget.isEnabled())
+    m_frameBudget.check(m_frameIndex, new_frame_ms, build_ms, render_ms, frameStats());
+  m_frameIndex++;
+  m_newFrameEnd = -1;
+}
+
+void ImGuiRenderer::setZeroAllocationCheck(int warmupFrames)
+{
+  if (!m_heap && warmupFrames >= 0)
+    qWarning("QtImGui: allocations are not tracked, see InitOptions::trackAllocations");
+  m_zeroAllocationFrame = warmupFrames < 0 ? -1 : qint64(m_frameIndex) + warmupFrames;
+}
+
+void ImGuiRenderer::setWindowCostTracking(bool enabled)
+{
+  if (enabled && !m_windowCostTracking) {
+    // The first report covers a full second
+    m_windowCostTracker.take();
+    m_windowCostsReported = m_phaseClock.isValid() ? m_phaseClock.nsecsElapsed() : 0;
+  }
+  m_windowCostTracking = enabled;
+}
+
+bool ImGuiRenderer::startRecording(const RecorderOptions &options)
+{
+  if (m_renderThread || m_backend) {
+    qWarning("QtImGui: recording needs the OpenGL renderer on the GUI thread");
+    return false;
+  }
+  m_recorderOptions = options;
+  m_recordingRequested = true;
+  return true;
+}
+
+void ImGuiRenderer::stopRecording()
+{
+  m_recordingRequested = false;
+}
+
+bool ImGuiRenderer::startDrawDataRecording(const QString &path)
+{
+  // The header stores this context's font atlas
+  ImGui::SetCurrentContext(g_ctx);
+
+  m_drawDataWriter.reset(new DrawDataWriter());
+  if (!m_drawDataWriter->open(path)) {
+    m_drawDataWriter.reset();
+    return false;
+  }
+  return true;
+}
+
+void ImGuiRenderer::stopDrawDataRecording()
+{
+  m_drawDataWriter.reset();
+}
+
+FrameRecorder::Stats ImGuiRenderer::recordingStats() const
+{
+  return m_recorder ? m_recorder->stats() : m_lastRecordingStats;
+}
+
+void ImGuiRenderer::updateRecording(const ImDrawData *drawData)
+{
+  if (m_recordingRequested && !m_recorder) {
+    m_recorder.reset(new FrameRecorder(this, m_recorderOptions));
+    m_lastRecordingStats = FrameRecorder::Stats();
+    if (!m_recorder->start()) {
+      m_recorder.reset();
+      m_recordingRequested = false;
+    }
+  } else if (!m_recordingRequested && m_recorder) {
+    m_recorder->finish();
+    m_lastRecordingStats = m_recorder->stats();
+    m_recorder.reset();
+  }
+
+  if (m_recorder) {
+    m_recorder->capture(QSize((int)(drawData->DisplaySize.x * drawData->FramebufferScale.x),
+                              (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y)));
+  }
+}
+
+QImage ImGuiRenderer::renderToImage(ImDrawData *drawData)
+{
+  render(drawData);
+  if (m_offscreen)
+    return m_offscreen->toImage();
+  if (auto *raster = dynamic_cast<SoftwareRasterizer*>(m_backend.get()))
+    return raster->image();
+  return QImage();
+}
+
+DrawDataSnapshot *ImGuiRenderer::takeSnapshot(ImDrawData *drawData, DrawDataSnapshot::Mode mode)
+{
+    if (!drawData) {
+        ImGui::SetCurrentContext(g_ctx);
+        drawData = ImGui::GetDrawData();
+    }
+    return m_snapshots.take(drawData, mode);
+}
+
+void ImGuiRenderer::releaseSnapshot(DrawDataSnapshot *snapshot)
+{
+    m_snapshots.release(snapshot);
+}
+
+void ImGuiRenderer::viewport(const char *id, const ViewportCallback &callback)
+{
+    // Select current context
+    ImGui::SetCurrentContext(g_ctx);
+
+    // Viewport callbacks issue GL calls, the GUI thread has no context when GL is deferred
+    if (m_deferredGL)
+        return;
+
+    const ImVec2 size = ImGui::GetContentRegionAvail();
+    if (size.x <= 0.0f || size.y <= 0.0f)
+        return;
+
+    const qreal dpr = m_window->devicePixelRatio();
+    const QSize pixelSize(qMax(1, qRound(size.x * dpr)), qMax(1, qRound(size.y * dpr)));
+    QOpenGLFramebufferObject *fbo = m_viewports.acquire(ImGui::GetID(id), pixelSize);
+
+    // Backup GL state
+    GLint last_framebuffer; glGetIntegerv(GL_FRAMEBUFFER_BINDING, &last_framebuffer);
+    GLint last_viewport[4]; glGetIntegerv(GL_VIEWPORT, last_viewport);
+
+    fbo->bind();
+    glViewport(0, 0, pixelSize.width(), pixelSize.height());
+    callback(fbo, pixelSize);
+
+    // Restore modified GL state
+    glBindFramebuffer(GL_FRAMEBUFFER, last_framebuffer);
+    glViewport(last_viewport[0], last_viewport[1], (GLsizei)last_viewport[2], (GLsizei)last_viewport[3]);
+
+    // The FBO is bucket sized, only show the part that was rendered (GL textures are bottom-up)
+    const float u = float(pixelSize.width()) / fbo->width();
+    const float v = float(pixelSize.height()) / fbo->height();
+    ImGui::Image((ImTextureID)(size_t)fbo->texture(), size, ImVec2(0.0f, v), ImVec2(u, 0.0f));
 }
 
 ImGuiRenderer::ImGuiRenderer()
   : g_ctx(nullptr)
 {
+  // windowCostsUpdated() may be connected across threads
+  qRegisterMetaType<QtImGui::WindowCosts>("QtImGui::WindowCosts");
+
+  QMutexLocker lock(&g_renderersMutex);
+  m_id = ++g_lastRendererId;
+  g_renderers.append(this);
 }
 
 ImGuiRenderer::~ImGuiRenderer()
 {
+  {
+    QMutexLocker lock(&g_renderersMutex);
+    g_renderers.removeOne(this);
+  }
+
+  // stop rendering before the state it reads goes away; a render thread releases the
+  // GL objects with its context current before destroying it
+  m_renderThread.reset();
+  m_backend.reset();
+  if (m_offscreen)
+    m_offscreen->makeCurrent();
+  releaseDeviceObjects();
+  m_recorder.reset();
+  m_offscreen.reset();
+
   // remove this context
-  ImGui::DestroyContext(g_ctx);
+  if (g_ctx)
+    Allocator::detach(g_ctx);
+  {
+    Allocator::ScopedOwner owner(m_heap);
+    ImGui::DestroyContext(g_ctx);
+  }
+  // The heap stays until the blocks that outlive the context are freed
+  if (m_heap) {
+    m_heap->trim();
+    Allocator::release(m_heap);
+    m_heap = nullptr;
+  }
 }
 
 void ImGuiRenderer::onMousePressedChange(QMouseEvent *event)
@@ -509,6 +1256,7 @@ void ImGuiRenderer::setCursorPos(const ImGuiIO& io)
 
 bool ImGuiRenderer::eventFilter(QObject *watched, QEvent *event)
 {
+  QTIMGUI_ZONE("QtImGui eventFilter");
   if (watched == m_window->object()) {
     switch (event->type()) {
     case QEvent::MouseButtonDblClick:
@@ -530,6 +1278,12 @@ bool ImGuiRenderer::eventFilter(QObject *watched, QEvent *event)
   return QObject::eventFilter(watched, event);
 }
 
+QList<ImGuiRenderer*> ImGuiRenderer::renderers()
+{
+    QMutexLocker lock(&g_renderersMutex);
+    return g_renderers;
+}
+
 ImGuiRenderer* ImGuiRenderer::instance() {
     static ImGuiRenderer* instance = nullptr;
     if (!instance) {
@@ -1,12 +1,36 @@
 #pragma once
 
-#include <QOpenGLExtraFunctions>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
 #include <QObject>
 #include <QPoint>
 #include <imgui.h>
+#include <atomic>
 #include <memory>
 
+#include "BufferTrim.h"
+#include "CountingOpenGLFunctions.h"
+#include "DrawDataRecording.h"
+#include "DrawDataSnapshot.h"
+#include "FrameBudget.h"
+#include "FrameRecorder.h"
+#include "FrameTimings.h"
+#include "GlDebug.h"
+#include "GlResources.h"
+#include "GpuTimer.h"
+#include "ImGuiAllocator.h"
+#include "MemoryStats.h"
+#include "OffscreenTarget.h"
+#include "QtImGui.h"
+#include "RenderBackend.h"
+#include "RenderThread.h"
+#include "ViewportPool.h"
+#include "WindowCost.h"
+
 class QMouseEvent;
+class QOpenGLContext;
 class QWheelEvent;
 class QKeyEvent;
 
@@ -26,20 +50,188 @@ public:
     virtual void setCursorPos(const QPoint& local_pos) = 0;
 };
 
-class ImGuiRenderer : public QObject, QOpenGLExtraFunctions {
+class ImGuiRenderer;
+
+// Passed to ImDrawList::AddCallback() callbacks through ImGuiRenderer::callbackContext().
+// The renderer re-applies its own GL state after every callback returns, so callbacks
+// may freely change GL state without saving it.
+struct RenderCallbackContext {
+    ImGuiRenderer *renderer = nullptr;
+    const ImDrawData *drawData = nullptr;
+    float projection[4][4];          // Orthographic projection used by ImGui, column-major
+    ImVec2 framebufferScale;         // Pixels per ImGui unit (devicePixelRatio)
+    int framebufferX = 0;            // Origin of the GL viewport, in pixels
+    int framebufferY = 0;
+    int framebufferWidth = 0;        // Size of the GL viewport, in pixels
+    int framebufferHeight = 0;
+};
+
+class ImGuiRenderer : public QObject, CountingOpenGLFunctions {
     Q_OBJECT
 public:
     void initialize(WindowWrapper *window);
+    void initialize(WindowWrapper *window, const InitOptions &options);
+    // Without a window: OpenGL draws into an FBO on a QOffscreenSurface, Backend::Software
+    // into its QImage. Other backends fall back to Backend::Software.
+    void initializeOffscreen(WindowWrapper *window, const InitOptions &options);
     void newFrame();
-    void render();
+    // Renders `drawData`, by default the current frame's (ImGui::GetDrawData())
+    void render(ImDrawData *drawData = nullptr);
+    void viewport(const char *id, const ViewportCallback &callback);
     bool eventFilter(QObject *watched, QEvent *event);
 
+    const ViewportPool::Stats &viewportStats() const { return m_viewports.stats(); }
+
+    // Color the window is cleared with before each frame in threaded rendering mode
+    void setClearColor(const ImVec4 &color) { m_clearColor = color; }
+    bool isThreaded() const { return m_renderThread != nullptr; }
+
+    // io.DeltaTime of every frame, in seconds. 0 (the default for windows) measures wall time.
+    void setFixedDeltaTime(float seconds) { m_fixedDeltaTime = seconds; }
+
+    // Renders like render() and reads the result back. Only offscreen and
+    // Backend::Software renderers produce an image.
+    QImage renderToImage(ImDrawData *drawData = nullptr);
+
+    // Records the rendered frames to a Y4M stream or PNG sequence, see FrameRecorder. The
+    // recorder is created and finished by the next render(), where the GL context is current.
+    // Not available with threaded rendering or the non-OpenGL backends.
+    bool startRecording(const RecorderOptions &options);
+    void stopRecording();
+    bool isRecording() const { return m_recorder != nullptr || m_recordingRequested; }
+    FrameRecorder::Stats recordingStats() const;
+
+    // Streams every frame passed to render() into a DrawDataWriter recording
+    bool startDrawDataRecording(const QString &path);
+    void stopDrawDataRecording();
+    const DrawDataWriter *drawDataRecording() const { return m_drawDataWriter.get(); }
+
+    // GL calls, uploads and CPU time of the last render pass of the built-in OpenGL renderer.
+    // Safe to call while a render thread or the Qt Quick render thread is drawing.
+    FrameStats frameStats() const;
+    FrameTotals totalStats() const;
+
+    // Times the passes of the built-in OpenGL renderer on the GPU, see GpuTimer. Off by
+    // default, results show up in FrameStats::gpuMs and listGpuTimes() a few frames late.
+    void setGpuTiming(bool enabled) { m_gpuTiming = enabled; }
+    bool gpuTiming() const { return m_gpuTiming; }
+
+    // GPU time of each draw list of the last timed pass
+    std::vector<ListGpuTime> listGpuTimes() const;
+
+    // KHR_debug groups around the pass and each draw list (named after its window), labels
+    // on the renderer's GL objects, and driver messages logged to the "qtimgui.gl" category.
+    // Off by default; applied by the next pass of the built-in OpenGL renderer.
+    void setGlDebugging(bool enabled) { m_glDebugging = enabled; }
+    bool glDebugging() const { return m_glDebugging; }
+
+    // Attributes vertices, indices, commands, uploads and, with GPU timing, GPU time to the
+    // ImGui window owning each draw list. Once per second windowCostsUpdated() reports the
+    // per-frame averages; drawRenderProfiler() shows the last table. Off by default.
+    void setWindowCostTracking(bool enabled);
+    bool windowCostTracking() const { return m_windowCostTracking; }
+    const WindowCosts &windowCosts() const { return m_windowCosts; }
+    void drawRenderProfiler(bool *open = nullptr) const { WindowCostTracker::drawWindow(m_windowCosts, open); }
+
+    // Allocations of this renderer's ImGui context through ImGui's allocator, when
+    // InitOptions::trackAllocations installed QtImGui's (see ImGuiAllocator.h), zero
+    // otherwise: since creation, during
+    // the last frame (from the end of the previous render() to the end of the last one)
+    // and during each phase of the last frame.
+    AllocationStats allocationStats() const { return m_heap ? m_heap->stats() : AllocationStats(); }
+    const AllocationStats &frameAllocations() const { return m_frameAllocations; }
+    const AllocationStats &phaseAllocations(FrameTimings::Phase phase) const { return m_phaseAllocations[phase]; }
+
+    // Memory held by the allocator selected with InitOptions::allocator, and release of
+    // its cached memory (empty slabs, unused chunks). Returns the bytes released.
+    HeapStats allocatorStats() const { return m_heap ? m_heap->heapStats() : HeapStats(); }
+    qint64 trimAllocator() { return m_heap ? m_heap->trim() : 0; }
+
+    // Draw list buffers and the VBO/IBO keep the size of the largest frame they held; once
+    // frames stay well below it for TrimOptions::quietFrames, they are shrunk back (see
+    // HighWaterMark). On by default, quietFrames = 0 disables it. trimStats() reports
+    // their capacity, high-water marks and the trims so far.
+    void setTrimOptions(const TrimOptions &options);
+    TrimOptions trimOptions() const;
+    TrimStats trimStats() const;
+
+    // Test mode: aborts with qFatal() when a frame allocates after `warmupFrames` more
+    // frames. Steady-state frames of a static UI should not allocate. -1 disables it.
+    void setZeroAllocationCheck(int warmupFrames);
+
+    // Logs the frames whose newFrame + UI build + render time exceeds a budget, with a
+    // breakdown, to the "qtimgui.framebudget" category. See FrameBudget.
+    void setFrameBudget(const FrameBudgetOptions &options) { m_frameBudget.setOptions(options); }
+    const FrameBudgetOptions &frameBudget() const { return m_frameBudget.options(); }
+    int overBudgetFrames() const { return m_frameBudget.overBudgetFrames(); }
+
+    // CPU time of newFrame(), of the UI code and of render() over the last frames, for the
+    // GUI thread. frameTimings().drawWindow() shows them in an ImGui window.
+    const FrameTimings &frameTimings() const { return m_frameTimings; }
+    void clearFrameTimings() { m_frameTimings.clear(); }
+
+    // Backend selected with InitOptions::backend, nullptr for the built-in OpenGL renderer
+    RenderBackend *backend() const { return m_backend.get(); }
+
+    // Pooled deep copy of `drawData` (by default the current frame's), for recording, remote
+    // viewing or rendering from another thread. Give it back with releaseSnapshot(), from
+    // any thread. Snapshots keep their buffers, so steady-state frames do not allocate.
+    DrawDataSnapshot *takeSnapshot(ImDrawData *drawData = nullptr, DrawDataSnapshot::Mode mode = DrawDataSnapshot::Copy);
+    void releaseSnapshot(DrawDataSnapshot *snapshot);
+
+    // Heap allocations made by snapshots during the last complete frame, should be 0 after warm-up
+    int snapshotAllocations() const { return m_snapshotAllocations; }
+
+    // For integrations drawing from a thread that owns its own GL context (render thread,
+    // Qt Quick scene graph): initializeGL() runs there with the context current while the
+    // GUI thread is blocked, renderDrawData() then only reads the given draw data.
+    // `framebufferOffset` is the bottom-left corner of the target area, in pixels.
+    void initializeGL();
+    void renderDrawData(ImDrawData *drawData, const QPoint &framebufferOffset = QPoint());
+
+    // Counterpart of initializeGL(), with the same context current: deletes the program,
+    // buffers, VAO, font texture, timer queries and viewport FBOs. The renderer also does it
+    // when that QOpenGLContext is about to be destroyed (e.g. a reparented QOpenGLWidget),
+    // and creates them again on the context current at the next frame or initializeGL().
+    void releaseGL() { releaseDeviceObjects(); }
+
+    // GL objects created, deleted and leaked by this renderer, and by every renderer of
+    // the process including destroyed ones: live() of the latter is 0 once all are gone.
+    GlResourceStats glResourceStats() const { return m_glResources.stats(); }
+    static GlResourceStats totalGlResourceStats() { return GlResourceTracker::processStats(); }
+
     static ImGuiRenderer *instance();
 
+    // Renderers alive in the process, in creation order, and this one's position in that
+    // order (1-based, never reused). For process-wide reporting such as MetricsExporter.
+    static QList<ImGuiRenderer*> renderers();
+    int id() const { return m_id; }
+
+    // Bytes of the built-in OpenGL renderer's font texture, 0 before it is created
+    qint64 fontTextureBytes() const { return m_fontTextureBytes; }
+
+    // Declares a texture the application passes to ImGui::Image(), so memoryStats()
+    // accounts for it. Registering the same texture again updates its size.
+    void registerTexture(ImTextureID texture, qint64 bytes);
+    void unregisterTexture(ImTextureID texture);
+
+    // GPU and CPU memory held by this renderer: textures, VBO/IBO, viewport and offscreen
+    // FBOs, recording buffers and the ImGui context's heap. totalMemoryStats() sums all live renderers, plus the ImGui
+    // allocations made outside of any context. Call from the GUI thread.
+    MemoryStats memoryStats() const;
+    static MemoryStats totalMemoryStats();
+
+    // Context of the draw callback being run on the calling thread, nullptr outside of callbacks
+    static const RenderCallbackContext *callbackContext();
+
 public:
     ImGuiRenderer();
     ~ImGuiRenderer();
 
+signals:
+    // Window costs of the last second, costliest first, see setWindowCostTracking()
+    void windowCostsUpdated(const QtImGui::WindowCosts &costs);
+
 private:
     void onMousePressedChange(QMouseEvent *event);
     void onWheel(QWheelEvent *event);
@@ -48,9 +240,16 @@ private:
     void updateCursorShape(const ImGuiIO &io);
     void setCursorPos(const ImGuiIO &io);
 
-    void renderDrawList(ImDrawData *draw_data);
+    void setupRenderState(const RenderCallbackContext &ctx);
+    void setVertexOffset(const char *offset);
+    void renderDrawList(ImDrawData *draw_data, const QPoint &fb_offset);
     bool createFontsTexture();
     bool createDeviceObjects();
+    void releaseDeviceObjects();
+    void destroyDeviceObjects(bool contextCurrent);
+    void updateRecording(const ImDrawData *drawData);
+    void updateGlDebug();
+    void trimDrawListBuffers();
 
     std::unique_ptr<WindowWrapper> m_window;
     double       g_Time = 0.0f;
@@ -62,6 +261,63 @@ private:
     int          g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
     int          g_AttribLocationPosition = 0, g_AttribLocationUV = 0, g_AttribLocationColor = 0;
     unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
+    QOpenGLContext *m_glContext = nullptr;  // Owning the objects above, nullptr once released
+    QMetaObject::Connection m_glContextDestroyed;
+    GlResourceTracker m_glResources;
+
+    ViewportPool m_viewports;
+    SnapshotPool m_snapshots;
+    int m_snapshotAllocations = 0;
+    std::unique_ptr<RenderThread> m_renderThread;
+    ImVec4 m_clearColor;
+    bool m_deferredGL = false;  // GL is initialized and drawn by another thread
+    std::unique_ptr<RenderBackend> m_backend;
+    bool m_backendCreated = false;
+    bool m_backendReady = false;    // createDeviceObjects() succeeded
+    std::unique_ptr<OffscreenTarget> m_offscreen;
+    float m_fixedDeltaTime = 0.0f;
+    std::unique_ptr<FrameRecorder> m_recorder;
+    RecorderOptions m_recorderOptions;
+    FrameRecorder::Stats m_lastRecordingStats;
+    bool m_recordingRequested = false;
+    std::unique_ptr<DrawDataWriter> m_drawDataWriter;
+    mutable QMutex m_statsMutex;
+    FrameStats m_frameStats;    // Last complete pass, m_glCounters collects the next one
+    FrameTotals m_totalStats;
+    int m_id = 0;
+    std::atomic<qint64> m_fontTextureBytes { 0 };
+    std::atomic<bool> m_gpuTiming { false };
+    bool m_gpuTimerResolved = false;
+    GpuTimer m_gpuTimer;        // Only used where the GL context is current
+    std::vector<ListGpuTime> m_listGpuTimes;
+    TrimOptions m_trimOptions;  // Guarded by m_statsMutex, like m_trimStats and m_userTextures
+    TrimStats m_trimStats;
+    QHash<ImTextureID, qint64> m_userTextures;
+    HighWaterMark m_drawListHighWater;
+    HighWaterMark m_vboHighWater;   // Only used where the GL context is current
+    HighWaterMark m_iboHighWater;
+    qint64 m_vboCapacity = 0;
+    qint64 m_iboCapacity = 0;
+    std::atomic<bool> m_glDebugging { false };
+    bool m_glDebugActive = false;
+    bool m_glDebugResolved = false;
+    GlDebug m_glDebug;
+    std::atomic<bool> m_windowCostTracking { false };
+    WindowCostTracker m_windowCostTracker;
+    WindowCosts m_windowCosts;
+    qint64 m_windowCostsReported = 0;   // m_phaseClock time of the last report
+    QElapsedTimer m_phaseClock;
+    qint64 m_newFrameEnd = -1;  // Clock time at the end of newFrame(), -1 outside of a frame
+    float m_newFrameMs = 0.0f;
+    FrameTimings m_frameTimings;
+    FrameBudget m_frameBudget;
+    quint64 m_frameIndex = 0;   // Frames passed to render()
+    ContextHeap *m_heap = nullptr;     // Owned by the Allocator registry
+    AllocationStats m_newFrameEndAllocations;
+    AllocationStats m_frameEndAllocations;
+    AllocationStats m_frameAllocations;
+    AllocationStats m_phaseAllocations[FrameTimings::PhaseCount];
+    qint64 m_zeroAllocationFrame = -1;  // First frame checked by setZeroAllocationCheck()
 
     ImGuiContext* g_ctx = nullptr;
 };
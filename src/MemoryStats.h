@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QtGlobal>
+
+namespace QtImGui {
+
+// Memory held by a renderer, see ImGuiRenderer::memoryStats(), or by all of them
+struct MemoryStats {
+    // GPU, built-in OpenGL renderer
+    qint64 fontTextureBytes = 0;
+    qint64 userTextureBytes = 0;    // Textures declared with ImGuiRenderer::registerTexture()
+    qint64 bufferBytes = 0;         // VBO + IBO capacity
+    qint64 viewportFboBytes = 0;    // viewport() FBOs, attached or pooled
+    qint64 offscreenFboBytes = 0;   // FBO of an offscreen renderer
+    qint64 recorderBytes = 0;       // Pixel-pack buffers of a frame recording
+    int userTextures = 0;
+
+    // CPU
+    qint64 heapBytes = 0;           // Reserved by the ImGui context's allocator, see HeapStats
+    qint64 drawListBytes = 0;       // Part of heapBytes: draw list buffer capacity
+    qint64 snapshotBytes = 0;       // Part of heapBytes: pooled DrawDataSnapshot buffers
+
+    qint64 gpuBytes() const
+    {
+        return fontTextureBytes + userTextureBytes + bufferBytes + viewportFboBytes + offscreenFboBytes + recorderBytes;
+    }
+    qint64 cpuBytes() const { return heapBytes; }
+
+    MemoryStats &operator+=(const MemoryStats &other)
+    {
+        fontTextureBytes += other.fontTextureBytes;
+        userTextureBytes += other.userTextureBytes;
+        bufferBytes += other.bufferBytes;
+        viewportFboBytes += other.viewportFboBytes;
+        offscreenFboBytes += other.offscreenFboBytes;
+        recorderBytes += other.recorderBytes;
+        userTextures += other.userTextures;
+        heapBytes += other.heapBytes;
+        drawListBytes += other.drawListBytes;
+        snapshotBytes += other.snapshotBytes;
+        return *this;
+    }
+};
+
+} // namespace QtImGui
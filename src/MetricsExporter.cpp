@@ -0,0 +1,252 @@
+#include "MetricsExporter.h"
+
+#include <QSaveFile>
+#include <cstdio>
+#include <vector>
+
+#ifdef QT_NETWORK_LIB
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#endif
+
+#include "ImGuiRenderer.h"
+
+namespace QtImGui {
+
+namespace {
+
+class Writer {
+public:
+    explicit Writer(QByteArray &out) : m_out(out) {}
+
+    void header(const char *name, const char *type, const char *help)
+    {
+        m_out.append("# HELP ").append(name).append(' ').append(help).append('\n');
+        m_out.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+    }
+
+    // `labels` is the inside of the braces, without them
+    void sample(const char *name, const QByteArray &labels, double value)
+    {
+        char number[64];
+        std::snprintf(number, sizeof(number), "%.17g", value);
+        m_out.append(name).append('{').append(labels).append("} ").append(number).append('\n');
+    }
+
+private:
+    QByteArray &m_out;
+};
+
+#ifdef QT_NETWORK_LIB
+const int kMaxRequestSize = 16 * 1024;
+#endif
+
+QByteArray rendererLabel(const ImGuiRenderer *renderer)
+{
+    return "renderer=\"" + QByteArray::number(renderer->id()) + "\"";
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_textfileTimer, &QTimer::timeout, this, &MetricsExporter::onTextfileTimer);
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+bool MetricsExporter::listen(quint16 port)
+{
+#ifdef QT_NETWORK_LIB
+    if (!m_server) {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+    }
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qWarning("QtImGui: cannot serve metrics on port %u: %s", unsigned(port), qPrintable(m_server->errorString()));
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(port);
+    qWarning("QtImGui: built without Qt Network, metrics can only be written to a file");
+    return false;
+#endif
+}
+
+bool MetricsExporter::writeTextfile(const QString &path, int intervalMs)
+{
+    m_textfilePath = path;
+    onTextfileTimer();
+    m_textfileTimer.start(intervalMs);
+    return true;
+}
+
+void MetricsExporter::stop()
+{
+#ifdef QT_NETWORK_LIB
+    if (m_server)
+        m_server->close();
+#endif
+    m_textfileTimer.stop();
+}
+
+void MetricsExporter::onTextfileTimer()
+{
+    // Scrapers never see a partial file
+    QSaveFile file(m_textfilePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(metrics()) < 0 || !file.commit())
+        qWarning("QtImGui: cannot write metrics to %s", qPrintable(m_textfilePath));
+}
+
+void MetricsExporter::onNewConnection()
+{
+#ifdef QT_NETWORK_LIB
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, socket, [socket]() {
+            // The request itself does not matter, answer once its headers are in
+            const QByteArray request = socket->property("qtimgui_request").toByteArray() + socket->readAll();
+            if (!request.contains("\r\n\r\n")) {
+                if (request.size() > kMaxRequestSize)
+                    socket->abort();
+                else
+                    socket->setProperty("qtimgui_request", request);
+                return;
+            }
+            const QByteArray body = metrics();
+            socket->write("HTTP/1.0 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Connection: close\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n");
+            socket->write(body);
+            socket->disconnectFromHost();
+        });
+    }
+#endif
+}
+
+QByteArray MetricsExporter::metrics()
+{
+    const QList<ImGuiRenderer*> renderers = ImGuiRenderer::renderers();
+    QByteArray out;
+    Writer w(out);
+
+    w.header("qtimgui_frames_total", "counter", "Frames passed to render().");
+    for (const ImGuiRenderer *r : renderers)
+        w.sample("qtimgui_frames_total", rendererLabel(r), double(r->frameTimings().histogram(FrameTimings::Render).cumulative.back()));
+
+    w.header("qtimgui_frame_phase_seconds", "histogram", "CPU time of newFrame(), of the UI build and of render().");
+    for (const ImGuiRenderer *r : renderers) {
+        for (int p = 0; p < FrameTimings::PhaseCount; p++) {
+            const FrameTimings::Phase phase = FrameTimings::Phase(p);
+            const FrameTimings::Histogram h = r->frameTimings().histogram(phase);
+            const QByteArray labels = rendererLabel(r) + ",phase=\"" + FrameTimings::phaseName(phase) + "\"";
+            for (size_t b = 0; b < h.boundsMs.size(); b++)
+                w.sample("qtimgui_frame_phase_seconds_bucket", labels + ",le=\"" + QByteArray::number(h.boundsMs[b] / 1000.0) + "\"", double(h.cumulative[b]));
+            w.sample("qtimgui_frame_phase_seconds_bucket", labels + ",le=\"+Inf\"", double(h.cumulative.back()));
+            w.sample("qtimgui_frame_phase_seconds_sum", labels, h.sumMs / 1000.0);
+            w.sample("qtimgui_frame_phase_seconds_count", labels, double(h.cumulative.back()));
+        }
+    }
+
+    // Pass totals of the built-in OpenGL renderer
+    const struct {
+        const char *name;
+        const char *help;
+        quint64 FrameTotals::*field;
+    } counters[] = {
+        { "qtimgui_passes_total", "OpenGL render passes.", &FrameTotals::passes },
+        { "qtimgui_draw_calls_total", "glDrawElements calls.", &FrameTotals::drawCalls },
+        { "qtimgui_binds_total", "Program, VAO, buffer, texture and framebuffer bindings.", &FrameTotals::binds },
+        { "qtimgui_state_changes_total", "GL state changes.", &FrameTotals::stateChanges },
+        { "qtimgui_gl_queries_total", "glGet* and glIsEnabled calls, which may stall.", &FrameTotals::queries },
+        { "qtimgui_buffer_orphans_total", "glBufferData calls.", &FrameTotals::bufferOrphans },
+        { "qtimgui_buffer_reallocations_total", "glBufferData calls that changed the buffer size.", &FrameTotals::bufferReallocations },
+        { "qtimgui_uploaded_bytes_total", "Buffer and texture data sent to the driver.", &FrameTotals::bytesUploaded },
+    };
+    std::vector<FrameTotals> totals;
+    for (const ImGuiRenderer *r : renderers)
+        totals.push_back(r->totalStats());
+    for (const auto &counter : counters) {
+        w.header(counter.name, "counter", counter.help);
+        for (int i = 0; i < renderers.size(); i++)
+            w.sample(counter.name, rendererLabel(renderers[i]), double(totals[size_t(i)].*counter.field));
+    }
+
+    w.header("qtimgui_pass_cpu_seconds_total", "counter", "CPU time spent submitting OpenGL passes.");
+    for (int i = 0; i < renderers.size(); i++)
+        w.sample("qtimgui_pass_cpu_seconds_total", rendererLabel(renderers[i]), totals[size_t(i)].cpuMs / 1000.0);
+
+    w.header("qtimgui_pass_gpu_seconds", "gauge", "GPU time of a recent pass, with GPU timing enabled.");
+    for (const ImGuiRenderer *r : renderers) {
+        const FrameStats stats = r->frameStats();
+        if (stats.gpuMs >= 0.0)
+            w.sample("qtimgui_pass_gpu_seconds", rendererLabel(r), stats.gpuMs / 1000.0);
+    }
+
+    std::vector<MemoryStats> memory;
+    for (const ImGuiRenderer *r : renderers)
+        memory.push_back(r->memoryStats());
+    w.header("qtimgui_texture_bytes", "gauge", "Texture memory of the OpenGL renderer, font and registered user textures.");
+    for (int i = 0; i < renderers.size(); i++) {
+        w.sample("qtimgui_texture_bytes", rendererLabel(renderers[i]) + ",texture=\"font\"", double(memory[size_t(i)].fontTextureBytes));
+        w.sample("qtimgui_texture_bytes", rendererLabel(renderers[i]) + ",texture=\"user\"", double(memory[size_t(i)].userTextureBytes));
+    }
+
+    w.header("qtimgui_memory_bytes", "gauge", "GPU and CPU memory of a renderer, see ImGuiRenderer::memoryStats().");
+    for (int i = 0; i < renderers.size(); i++) {
+        const MemoryStats &m = memory[size_t(i)];
+        w.sample("qtimgui_memory_bytes", rendererLabel(renderers[i]) + ",memory=\"gpu\"", double(m.gpuBytes()));
+        w.sample("qtimgui_memory_bytes", rendererLabel(renderers[i]) + ",memory=\"cpu\"", double(m.cpuBytes()));
+    }
+    w.header("qtimgui_unattributed_heap_bytes", "gauge", "ImGui allocations made outside of any renderer's context.");
+    w.sample("qtimgui_unattributed_heap_bytes", QByteArray(), double(Allocator::unattributed()->heapStats().reservedBytes));
+
+    w.header("qtimgui_viewport_fbo_requests_total", "counter", "Viewport FBO requests, by pool hit or allocation.");
+    for (const ImGuiRenderer *r : renderers) {
+        const ViewportPool::Stats &pool = r->viewportStats();
+        w.sample("qtimgui_viewport_fbo_requests_total", rendererLabel(r) + ",result=\"hit\"", pool.reuses);
+        w.sample("qtimgui_viewport_fbo_requests_total", rendererLabel(r) + ",result=\"allocation\"", pool.allocations);
+    }
+
+    w.header("qtimgui_viewport_fbos", "gauge", "Viewport FBOs, attached to a viewport or pooled.");
+    for (const ImGuiRenderer *r : renderers) {
+        const ViewportPool::Stats &pool = r->viewportStats();
+        w.sample("qtimgui_viewport_fbos", rendererLabel(r) + ",state=\"live\"", pool.live);
+        w.sample("qtimgui_viewport_fbos", rendererLabel(r) + ",state=\"pooled\"", pool.pooled);
+    }
+
+    std::vector<TrimStats> trims;
+    for (const ImGuiRenderer *r : renderers)
+        trims.push_back(r->trimStats());
+    w.header("qtimgui_draw_buffer_bytes", "gauge", "Draw list (cpu) and VBO/IBO (gpu) buffer capacity.");
+    for (int i = 0; i < renderers.size(); i++) {
+        w.sample("qtimgui_draw_buffer_bytes", rendererLabel(renderers[i]) + ",memory=\"cpu\"", double(trims[size_t(i)].cpuCapacityBytes));
+        w.sample("qtimgui_draw_buffer_bytes", rendererLabel(renderers[i]) + ",memory=\"gpu\"", double(trims[size_t(i)].gpuCapacityBytes));
+    }
+    w.header("qtimgui_draw_buffer_trims_total", "counter", "Draw buffer shrinks after load spikes.");
+    for (int i = 0; i < renderers.size(); i++) {
+        w.sample("qtimgui_draw_buffer_trims_total", rendererLabel(renderers[i]) + ",memory=\"cpu\"", double(trims[size_t(i)].cpuTrims));
+        w.sample("qtimgui_draw_buffer_trims_total", rendererLabel(renderers[i]) + ",memory=\"gpu\"", double(trims[size_t(i)].gpuTrims));
+    }
+
+    w.header("qtimgui_gl_objects", "gauge", "GL objects of the OpenGL renderer alive on its context.");
+    for (const ImGuiRenderer *r : renderers)
+        w.sample("qtimgui_gl_objects", rendererLabel(r), double(r->glResourceStats().live()));
+    w.header("qtimgui_gl_objects_leaked_total", "counter", "GL objects dropped because their context was lost without being current, all renderers.");
+    w.sample("qtimgui_gl_objects_leaked_total", QByteArray(), double(ImGuiRenderer::totalGlResourceStats().leaked));
+
+    w.header("qtimgui_over_budget_frames_total", "counter", "Frames over the frame budget, when one is set.");
+    for (const ImGuiRenderer *r : renderers)
+        w.sample("qtimgui_over_budget_frames_total", rendererLabel(r), r->overBudgetFrames());
+
+    return out;
+}
+
+} // namespace QtImGui
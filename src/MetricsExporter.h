@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class QTcpServer;
+
+namespace QtImGui {
+
+// Publishes the statistics of every live ImGuiRenderer in the Prometheus text format:
+// frame phase histograms, pass totals (draw calls, uploads, GL queries), GPU time, texture
+// and memory sizes, viewport FBO pool hits, draw buffer capacity and trims, over-budget frames.
+//
+// Either served over HTTP on localhost (needs QT += network / Qt Network at build time) or
+// written periodically to a file, e.g. for node_exporter's textfile collector. Lives on the
+// GUI thread, like the renderers it reads.
+class MetricsExporter : public QObject {
+    Q_OBJECT
+public:
+    explicit MetricsExporter(QObject *parent = nullptr);
+    ~MetricsExporter();
+
+    // Answers any HTTP request on 127.0.0.1:`port` with the metrics
+    bool listen(quint16 port = 9464);
+
+    // Rewrites `path` atomically every `intervalMs`
+    bool writeTextfile(const QString &path, int intervalMs = 15000);
+
+    void stop();
+
+    // Metrics of all live renderers, in the Prometheus text exposition format
+    static QByteArray metrics();
+
+private:
+    void onNewConnection();
+    void onTextfileTimer();
+
+    QTcpServer *m_server = nullptr;     // Only used with Qt Network
+    QTimer m_textfileTimer;
+    QString m_textfilePath;
+};
+
+} // namespace QtImGui
@@ -0,0 +1,69 @@
+#include "OffscreenTarget.h"
+
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+
+namespace QtImGui {
+
+OffscreenTarget::OffscreenTarget()
+{
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    // The FBO must be deleted with its context current
+    if (m_fbo && makeCurrent()) {
+        m_fbo.reset();
+        m_context->doneCurrent();
+    }
+}
+
+bool OffscreenTarget::create()
+{
+    m_context.reset(new QOpenGLContext());
+    if (QOpenGLContext *share = QOpenGLContext::globalShareContext())
+        m_context->setShareContext(share);
+    if (!m_context->create()) {
+        qWarning("QtImGui: failed to create the offscreen OpenGL context");
+        m_context.reset();
+        return false;
+    }
+
+    m_surface.reset(new QOffscreenSurface());
+    m_surface->setFormat(m_context->format());
+    m_surface->create();
+    return makeCurrent();
+}
+
+bool OffscreenTarget::makeCurrent()
+{
+    return m_context && m_context->makeCurrent(m_surface.get());
+}
+
+QOpenGLFramebufferObject *OffscreenTarget::bind(const QSize &pixelSize)
+{
+    if (!makeCurrent())
+        return nullptr;
+
+    if (!m_fbo || m_fbo->size() != pixelSize) {
+        m_fbo.reset();
+        m_fbo.reset(new QOpenGLFramebufferObject(pixelSize, QOpenGLFramebufferObject::CombinedDepthStencil));
+    }
+    m_fbo->bind();
+    return m_fbo.get();
+}
+
+QImage OffscreenTarget::toImage() const
+{
+    return m_fbo ? m_fbo->toImage() : QImage();
+}
+
+qint64 OffscreenTarget::bytes() const
+{
+    // RGBA8 color and a packed 24/8 depth/stencil buffer
+    const int bytesPerPixel = 8;
+    return m_fbo ? qint64(m_fbo->width()) * m_fbo->height() * bytesPerPixel : 0;
+}
+
+} // namespace QtImGui
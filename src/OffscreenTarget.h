@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <memory>
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QOpenGLFramebufferObject;
+
+namespace QtImGui {
+
+// OpenGL target of an offscreen renderer: a context on a QOffscreenSurface and an FBO.
+//
+// The context lives as long as the renderer, so back to back frames only pay for the
+// draw and the readback. The FBO is only reallocated when the pixel size changes.
+class OffscreenTarget {
+public:
+    OffscreenTarget();
+    ~OffscreenTarget();
+
+    // Creates the context, sharing with the global share context when there is one.
+    // Must be called on the GUI thread.
+    bool create();
+    bool makeCurrent();
+
+    // Makes the context current and binds an FBO of `pixelSize`
+    QOpenGLFramebufferObject *bind(const QSize &pixelSize);
+
+    // Reads the bound FBO back, in QImage::Format_ARGB32_Premultiplied
+    QImage toImage() const;
+
+    // Color and depth/stencil storage of the FBO, 0 before the first bind()
+    qint64 bytes() const;
+
+private:
+    std::unique_ptr<QOffscreenSurface> m_surface;
+    std::unique_ptr<QOpenGLContext> m_context;
+    std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+};
+
+} // namespace QtImGui
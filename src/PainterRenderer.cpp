@@ -0,0 +1,195 @@
+#include "PainterRenderer.h"
+
+#include <QPaintEvent>
+#include <QPainter>
+
+namespace QtImGui {
+
+namespace {
+
+// Bytes of tinted texture areas kept, least recently used ones are dropped first
+const int kTintCacheBytes = 4 * 1024 * 1024;
+
+inline quint64 packRect(const QRect &r)
+{
+    return quint64(quint16(r.x())) | quint64(quint16(r.y())) << 16
+         | quint64(quint16(r.width())) << 32 | quint64(quint16(r.height())) << 48;
+}
+
+inline QColor toQColor(ImU32 c)
+{
+    return QColor(int(c & 0xff), int((c >> 8) & 0xff), int((c >> 16) & 0xff), int((c >> 24) & 0xff));
+}
+
+inline ImU32 modulate(ImU32 a, ImU32 b)
+{
+    ImU32 out = 0;
+    for (int i = 0; i < 32; i += 8)
+        out |= ((((a >> i) & 0xff) * ((b >> i) & 0xff) + 127) / 255) << i;
+    return out;
+}
+
+inline ImU32 fetchTexel(const QImage *texture, const ImVec2 &uv)
+{
+    const int x = qBound(0, int(uv.x * texture->width()), texture->width() - 1);
+    const int y = qBound(0, int(uv.y * texture->height()), texture->height() - 1);
+    return reinterpret_cast<const ImU32*>(texture->constScanLine(y))[x];
+}
+
+} // namespace
+
+PainterRenderer::PainterRenderer(QObject *host, QPaintDevice *device)
+    : m_host(host)
+    , m_device(device)
+    , m_tinted(kTintCacheBytes)
+{
+    m_host->installEventFilter(this);
+}
+
+PainterRenderer::~PainterRenderer()
+{
+}
+
+bool PainterRenderer::createDeviceObjects()
+{
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    m_fontImage = QImage(pixels, width, height, width * 4, QImage::Format_RGBA8888).copy();
+    io.Fonts->TexID = (ImTextureID)&m_fontImage;
+
+    // Alpha fringes would be drawn as opaque flat triangles
+    ImGuiStyle &style = ImGui::GetStyle();
+    style.AntiAliasedLines = false;
+    style.AntiAliasedFill = false;
+    return true;
+}
+
+bool PainterRenderer::eventFilter(QObject *watched, QEvent *event)
+{
+    // Seen before the host's own paintEvent(), from which render() is called
+    if (watched == m_host && event->type() == QEvent::Paint)
+        m_paintRegion = static_cast<QPaintEvent*>(event)->region();
+    return QObject::eventFilter(watched, event);
+}
+
+const QImage &PainterRenderer::tintedTexture(const QImage *texture, ImU32 color, const QRect &rect)
+{
+    const TintKey key(qMakePair(texture, color), packRect(rect));
+    if (const QImage *cached = m_tinted.object(key))
+        return *cached;
+
+    QImage tinted = texture->copy(rect).convertToFormat(QImage::Format_RGBA8888);
+    for (int y = 0; y < tinted.height(); y++) {
+        ImU32 *line = reinterpret_cast<ImU32*>(tinted.scanLine(y));
+        for (int x = 0; x < tinted.width(); x++)
+            line[x] = modulate(line[x], color);
+    }
+    // Premultiplied ARGB is the raster engine's fast path for drawImage()
+    QImage *image = new QImage(tinted.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    const int cost = int(image->sizeInBytes());
+    if (cost > m_tinted.maxCost()) {
+        m_uncached = *image;
+        delete image;
+        return m_uncached;
+    }
+    m_tinted.insert(key, image, cost);
+    return *image;
+}
+
+void PainterRenderer::render(ImDrawData *drawData, const ImVec4 &clearColor)
+{
+    QPainter painter(m_device);
+    painter.setPen(Qt::NoPen);
+
+    const QRect bounds = m_paintRegion.isEmpty()
+        ? QRect(0, 0, int(drawData->DisplaySize.x), int(drawData->DisplaySize.y))
+        : m_paintRegion.boundingRect();
+
+    if (clearColor.w > 0.0f) {
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.fillRect(bounds, QColor::fromRgbF(clearColor.x, clearColor.y, clearColor.z, clearColor.w));
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+
+    const ImVec2 offset = drawData->DisplayPos;
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = drawData->CmdLists[n];
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            // There is no GPU state to reset or hand to a callback
+            if (pcmd->UserCallback)
+                continue;
+
+            const QRect clip = QRectF(QPointF(pcmd->ClipRect.x - offset.x, pcmd->ClipRect.y - offset.y),
+                                      QPointF(pcmd->ClipRect.z - offset.x, pcmd->ClipRect.w - offset.y))
+                                   .toAlignedRect() & bounds;
+            if (clip.isEmpty())
+                continue;
+
+            if (m_paintRegion.isEmpty())
+                painter.setClipRect(clip);
+            else
+                painter.setClipRegion(m_paintRegion & clip);
+            drawCommand(painter, cmd_list, pcmd, offset);
+        }
+    }
+
+    m_paintRegion = QRegion();
+}
+
+void PainterRenderer::drawCommand(QPainter &painter, const ImDrawList *cmdList, const ImDrawCmd *pcmd, const ImVec2 &offset)
+{
+    const QImage *texture = static_cast<const QImage*>(pcmd->TextureId);
+    if (!texture || texture->isNull())
+        return;
+
+    const ImDrawVert* vtx = cmdList->VtxBuffer.Data + pcmd->VtxOffset;
+    const ImDrawIdx* idx = cmdList->IdxBuffer.Data + pcmd->IdxOffset;
+    const QRectF clipBounds = painter.clipBoundingRect();
+
+    unsigned int i = 0;
+    while (i + 2 < pcmd->ElemCount) {
+        // PrimRect() and PrimRectUV() emit quads as (a, b, c, a, c, d)
+        if (i + 5 < pcmd->ElemCount && idx[i + 3] == idx[i] && idx[i + 4] == idx[i + 2]) {
+            const ImDrawVert &a = vtx[idx[i]], &b = vtx[idx[i + 1]], &c = vtx[idx[i + 2]], &d = vtx[idx[i + 5]];
+            const bool axisAligned = a.pos.y == b.pos.y && b.pos.x == c.pos.x && c.pos.y == d.pos.y && d.pos.x == a.pos.x
+                                  && a.uv.y == b.uv.y && b.uv.x == c.uv.x && c.uv.y == d.uv.y && d.uv.x == a.uv.x;
+            const bool sameColor = a.col == b.col && a.col == c.col && a.col == d.col;
+            // Mirrored UVs would need a flipped drawImage(), leave those to the generic path
+            const bool sameOrientation = (c.pos.x - a.pos.x) * (c.uv.x - a.uv.x) >= 0.0f
+                                      && (c.pos.y - a.pos.y) * (c.uv.y - a.uv.y) >= 0.0f;
+            if (axisAligned && sameColor && sameOrientation) {
+                const QRectF target = QRectF(QPointF(a.pos.x - offset.x, a.pos.y - offset.y),
+                                             QPointF(c.pos.x - offset.x, c.pos.y - offset.y)).normalized();
+                if (target.intersects(clipBounds)) {
+                    if (a.uv.x == c.uv.x && a.uv.y == c.uv.y) {
+                        // Untextured rect: the UVs all point at the atlas white pixel
+                        painter.fillRect(target, toQColor(modulate(a.col, fetchTexel(texture, a.uv))));
+                    } else {
+                        const QRectF source = QRectF(QPointF(a.uv.x * texture->width(), a.uv.y * texture->height()),
+                                                     QPointF(c.uv.x * texture->width(), c.uv.y * texture->height())).normalized();
+                        const QRect area = source.toAlignedRect() & texture->rect();
+                        if (!area.isEmpty())
+                            painter.drawImage(target, tintedTexture(texture, a.col, area), source.translated(-area.topLeft()));
+                    }
+                }
+                i += 6;
+                continue;
+            }
+        }
+
+        const ImDrawVert &v0 = vtx[idx[i]], &v1 = vtx[idx[i + 1]], &v2 = vtx[idx[i + 2]];
+        const QPointF points[3] = {
+            QPointF(v0.pos.x - offset.x, v0.pos.y - offset.y),
+            QPointF(v1.pos.x - offset.x, v1.pos.y - offset.y),
+            QPointF(v2.pos.x - offset.x, v2.pos.y - offset.y),
+        };
+        painter.setBrush(toQColor(modulate(v0.col, fetchTexel(texture, v0.uv))));
+        painter.drawConvexPolygon(points, 3);
+        i += 3;
+    }
+}
+
+} // namespace QtImGui
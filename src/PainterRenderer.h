@@ -0,0 +1,52 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QRegion>
+
+class QPaintDevice;
+class QPainter;
+
+namespace QtImGui {
+
+// QPainter backend for hosts without an OpenGL context, typically a plain QWidget.
+//
+// render() must be called from the host's paintEvent(). It only draws the commands
+// intersecting the region of that paint event. Axis-aligned quads, which are most of
+// ImGui's output (rects and glyphs), become fillRect() and drawImage() calls; the
+// remaining triangles are drawn flat with drawConvexPolygon(), in their first vertex
+// color. ImGui's own anti-aliasing is disabled since its alpha fringes need per-vertex
+// colors.
+//
+// ImTextureID values are `const QImage *` in Format_RGBA8888. Textured quads are drawn
+// from a copy of the texture area they show tinted with the quad color, kept in a
+// least-recently-used cache of a few MiB.
+class PainterRenderer : public QObject, public RenderBackend {
+public:
+    // `host` receives the paint events, `device` is painted on (the same widget, usually)
+    PainterRenderer(QObject *host, QPaintDevice *device);
+    ~PainterRenderer();
+
+    bool createDeviceObjects() override;
+    void render(ImDrawData *drawData, const ImVec4 &clearColor) override;
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    const QImage &tintedTexture(const QImage *texture, ImU32 color, const QRect &rect);
+    void drawCommand(QPainter &painter, const ImDrawList *cmdList, const ImDrawCmd *pcmd, const ImVec2 &offset);
+
+    QObject *m_host;
+    QPaintDevice *m_device;
+    QRegion m_paintRegion;
+    QImage m_fontImage;
+
+    // Tinted copies of texture areas, keyed by texture and color, then area
+    using TintKey = QPair<QPair<const QImage*, ImU32>, quint64>;
+    QCache<TintKey, QImage> m_tinted;
+    QImage m_uncached;      // Last area too large for the cache
+};
+
+} // namespace QtImGui
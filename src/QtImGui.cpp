@@ -24,6 +24,10 @@ public:
   void newFrame() { r->newFrame(); }
 
   void render() { r->render(); }
+
+  void viewport(const char *id, const ViewportCallback &callback) { r->viewport(id, callback); }
+
+  ImGuiRenderer* renderer() const { return r; }
 private:
   ImGuiRenderer* r;
 };
@@ -86,14 +90,18 @@ private:
 } // namespace
 
 RenderRef initialize(QWidget *window, bool defaultRender) {
+  return initialize(window, InitOptions(), defaultRender);
+}
+
+RenderRef initialize(QWidget *window, const InitOptions &options, bool defaultRender) {
   if (defaultRender) {
     auto* wrapper = new QWidgetWindowWrapper(window, ImGuiRenderer::instance());
-    ImGuiRenderer::instance()->initialize(wrapper);
+    ImGuiRenderer::instance()->initialize(wrapper, options);
     return reinterpret_cast<RenderRef>(dynamic_cast<QWindowWrapper*>(wrapper));
   } else {
     auto* render = new ImGuiRenderer();
     auto* wrapper = new QWidgetWindowWrapper(window, render);
-    render->initialize(wrapper);
+    render->initialize(wrapper, options);
     return reinterpret_cast<RenderRef>(dynamic_cast<QWindowWrapper*>(wrapper));
   }
 }
@@ -156,19 +164,85 @@ private:
 } // namespace
 
 RenderRef initialize(QWindow* window, bool defaultRender) {
+  return initialize(window, InitOptions(), defaultRender);
+}
+
+RenderRef initialize(QWindow* window, const InitOptions &options, bool defaultRender) {
   if (defaultRender) {
     auto* wrapper = new QWindowWindowWrapper(window, ImGuiRenderer::instance());
-    ImGuiRenderer::instance()->initialize(wrapper);
+    ImGuiRenderer::instance()->initialize(wrapper, options);
     return reinterpret_cast<RenderRef>(dynamic_cast<QWindowWrapper*>(wrapper));
   }
   else {
     auto* render = new ImGuiRenderer();
     auto* wrapper = new QWindowWindowWrapper(window, render);
-    render->initialize(wrapper);
+    render->initialize(wrapper, options);
     return reinterpret_cast<RenderRef>(dynamic_cast<QWindowWrapper*>(wrapper));
   }
 }
 
+namespace {
+
+class OffscreenWindowWrapper : public QWindowWrapper {
+public:
+    OffscreenWindowWrapper(const QSize &size, qreal dpr, ImGuiRenderer* r)
+      : QWindowWrapper(r), m_size(size), m_dpr(dpr)
+    {}
+    void installEventFilter(QObject *object) override {
+        m_object.installEventFilter(object);
+    }
+    QSize size() const override {
+        return m_size;
+    }
+    qreal devicePixelRatio() const override {
+        return m_dpr;
+    }
+    bool isActive() const override {
+        return false;
+    }
+    QPoint mapFromGlobal(const QPoint &p) const override {
+        return p;
+    }
+    QObject* object() override {
+        return &m_object;
+    }
+    void setCursorShape(Qt::CursorShape shape) override {
+        Q_UNUSED(shape);
+    }
+    void setCursorPos(const QPoint& local_pos) override {
+        Q_UNUSED(local_pos);
+    }
+
+    void resize(const QSize &size, qreal dpr) {
+        m_size = size;
+        m_dpr = dpr;
+    }
+
+private:
+    QSize m_size;
+    qreal m_dpr;
+    QObject m_object;   // Receives the events sent to the offscreen UI, if any
+};
+
+} // namespace
+
+RenderRef initializeOffscreen(const QSize &size, qreal devicePixelRatio, const InitOptions &options) {
+  auto* render = new ImGuiRenderer();
+  auto* wrapper = new OffscreenWindowWrapper(size, devicePixelRatio, render);
+  render->initializeOffscreen(wrapper, options);
+  return reinterpret_cast<RenderRef>(dynamic_cast<QWindowWrapper*>(wrapper));
+}
+
+void setOffscreenSize(RenderRef ref, const QSize &size, qreal devicePixelRatio) {
+  auto wrapper = dynamic_cast<OffscreenWindowWrapper*>(reinterpret_cast<QWindowWrapper*>(ref));
+  if (wrapper)
+    wrapper->resize(size, devicePixelRatio);
+}
+
+QImage renderToImage(RenderRef ref) {
+  return renderer(ref)->renderToImage();
+}
+
 void newFrame(RenderRef ref) {
   if (!ref) {
     ImGuiRenderer::instance()->newFrame();
@@ -188,4 +262,29 @@ void render(RenderRef ref)
   }
 }
 
+ImGuiRenderer* renderer(RenderRef ref)
+{
+  if (!ref) {
+    return ImGuiRenderer::instance();
+  } else {
+    auto wrapper = reinterpret_cast<QWindowWrapper*>(ref);
+    return wrapper->renderer();
+  }
+}
+
+void viewport(const char *id, const ViewportCallback &callback, RenderRef ref)
+{
+  if (!ref) {
+    ImGuiRenderer::instance()->viewport(id, callback);
+  } else {
+    auto wrapper = reinterpret_cast<QWindowWrapper*>(ref);
+    wrapper->viewport(id, callback);
+  }
+}
+
+const RenderCallbackContext *callbackContext()
+{
+  return ImGuiRenderer::callbackContext();
+}
+
 } // namespace QtImGui
@@ -1,18 +1,112 @@
 #pragma once
 
+#include <functional>
+
 class QWidget;
 class QWindow;
+class QSize;
+class QImage;
+class QOpenGLFramebufferObject;
 
 namespace QtImGui {
 
+struct RenderCallbackContext;
+
 typedef void* RenderRef;
 
+class ImGuiRenderer;
+
+enum class Backend {
+    OpenGL,     // QOpenGLExtraFunctions on the window's current context
+    Rhi,        // QRhi, needs Qt >= 6.6 and a build with QTIMGUI_HAS_RHI
+    Software,   // Multithreaded CPU rasterizer, no GPU or GL driver involved
+    Painter,    // QPainter on a plain QWidget, called from its paintEvent()
+};
+
+enum class RhiApi {
+    OpenGL,
+    Vulkan,
+    Null,       // No GPU work, for measuring the CPU side of a frame
+};
+
+// Where the blocks ImGui allocates for a context come from, see ImGuiAllocator.h
+enum class AllocatorPolicy {
+    Malloc,     // The C heap
+    Pool,       // Size-class free lists carved from 64 KiB slabs, larger blocks from the C heap
+    FrameArena, // Pool, plus bump allocation in chunks inside Allocator::TransientScope
+};
+
+struct InitOptions {
+    // Submit GL commands from a dedicated thread owning the window's GL context.
+    // render() then only snapshots the draw data, so the next frame can be built
+    // while the previous one is drawn. Needs a plain QWindow (not a QOpenGLWindow),
+    // the window is cleared with ImGuiRenderer::setClearColor() before each frame
+    // and viewport() is not available.
+    bool threadedRendering = false;
+
+    // GL is set up and drawn by the caller through ImGuiRenderer::initializeGL() and
+    // renderDrawData(), render() does nothing. Used by ImGuiQuickItem.
+    bool externalRendering = false;
+
+    // Backend::Rhi renders through a QRhi owning the window's swapchain, using the
+    // graphics API in `rhiApi`. Needs a plain QWindow; ImTextureID values are then
+    // QRhiTexture pointers and viewport() is not available.
+    Backend backend = Backend::OpenGL;
+    RhiApi rhiApi = RhiApi::OpenGL;
+
+    // Backend::Software presents through a QBackingStore when the host is a QWindow.
+    // ImTextureID values are then `const QImage *` in Format_RGBA8888. Threads used
+    // to rasterize, including the calling one; 0 uses QThread::idealThreadCount().
+    int softwareThreads = 0;
+
+    // Backend::Painter needs a QWidget host and no GL context: call newFrame() and
+    // render() from the widget's paintEvent(), which only redraws the event's region.
+
+    // Counts the ImGui allocations of this renderer's context (allocationStats(),
+    // setZeroAllocationCheck()) by installing QtImGui's allocator, see ImGuiAllocator.h.
+    // Only possible from the first renderer, before ImGui allocated anything.
+    bool trackAllocations = false;
+
+    // Allocator serving this renderer's ImGui context. Pooling keeps the memory of long
+    // running processes with many contexts from fragmenting the C heap. Other policies
+    // than Malloc imply trackAllocations.
+    AllocatorPolicy allocator = AllocatorPolicy::Malloc;
+};
+
+// Called by viewport() with the FBO bound and the GL viewport set to `pixelSize`.
+// `pixelSize` is the content region size times devicePixelRatio, the FBO itself
+// can be larger than that.
+typedef std::function<void(QOpenGLFramebufferObject *fbo, const QSize &pixelSize)> ViewportCallback;
+
 #ifdef QT_WIDGETS_LIB
 RenderRef initialize(QWidget *window, bool defaultRender = true);
+RenderRef initialize(QWidget *window, const InitOptions &options, bool defaultRender = true);
 #endif
 
 RenderRef initialize(QWindow *window, bool defaultRender = true);
+RenderRef initialize(QWindow *window, const InitOptions &options, bool defaultRender = true);
 void newFrame(RenderRef ref = nullptr);
 void render(RenderRef ref = nullptr);
 
+// Headless rendering, without any window or timer. The UI has `size` in ImGui units and
+// images are `size * devicePixelRatio` pixels. options.backend may be OpenGL (offscreen
+// surface + FBO) or Software. Each call creates a renderer with its own ImGui context,
+// reused for every image; io.DeltaTime is fixed at 1/60 s.
+RenderRef initializeOffscreen(const QSize &size, qreal devicePixelRatio = 1.0, const InitOptions &options = InitOptions());
+void setOffscreenSize(RenderRef ref, const QSize &size, qreal devicePixelRatio = 1.0);
+
+// Renders the frame like render() and returns it, call after ImGui::Render()
+QImage renderToImage(RenderRef ref);
+
+// Renderer behind `ref`, or the default renderer
+ImGuiRenderer *renderer(RenderRef ref = nullptr);
+
+// Draws a render-to-texture viewport filling the remaining content region of
+// the current ImGui window. Call between newFrame() and ImGui::Render().
+void viewport(const char *id, const ViewportCallback &callback, RenderRef ref = nullptr);
+
+// From inside an ImDrawList::AddCallback() callback: projection, framebuffer size and
+// renderer of the pass running the callback (see ImGuiRenderer.h). nullptr elsewhere.
+const RenderCallbackContext *callbackContext();
+
 }
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <imgui.h>
+
+namespace QtImGui {
+
+// Draws ImDrawData in place of ImGuiRenderer's own OpenGL code. Backends own their
+// output (swapchain, image, ...), they are created from InitOptions::backend.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+
+    // Called from newFrame() before the first frame, with the ImGui context current.
+    // Uploads the font atlas and sets io.Fonts->TexID.
+    virtual bool createDeviceObjects() = 0;
+
+    // Draws and presents a frame, called from render() after ImGui::Render()
+    virtual void render(ImDrawData *drawData, const ImVec4 &clearColor) = 0;
+};
+
+} // namespace QtImGui
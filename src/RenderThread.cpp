@@ -0,0 +1,161 @@
+#include "RenderThread.h"
+
+#include "DrawDataSnapshot.h"
+#include "ImGuiRenderer.h"
+#include "Trace.h"
+#include <QGuiApplication>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QWindow>
+
+namespace QtImGui {
+
+RenderThread::RenderThread(ImGuiRenderer *renderer, QWindow *window)
+    : m_renderer(renderer)
+    , m_window(window)
+{
+}
+
+RenderThread::~RenderThread()
+{
+    if (m_threaded) {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_quit = true;
+            m_cond.wakeAll();
+        }
+        wait();
+    } else if (m_context) {
+        // GL objects can only be deleted with their context current
+        m_context->makeCurrent(m_window);
+        m_renderer->releaseGL();
+        m_context->doneCurrent();
+        m_context.reset();
+    }
+}
+
+void RenderThread::startRendering()
+{
+    // The native window has to exist before another thread can make a context current on it
+    if (!m_window->handle()) {
+        m_window->setSurfaceType(QSurface::OpenGLSurface);
+        m_window->create();
+    }
+
+    m_context.reset(new QOpenGLContext());
+    m_context->setFormat(m_window->requestedFormat());
+    if (!m_context->create()) {
+        qWarning("QtImGui: failed to create the render thread OpenGL context");
+        return;
+    }
+
+    m_threaded = QOpenGLContext::supportsThreadedOpenGL();
+    if (!m_threaded) {
+        initializeGL();
+        return;
+    }
+
+    m_context->moveToThread(this);
+    start();
+
+    // Device object creation reads the font atlas of the ImGui context, keep the
+    // GUI thread out of ImGui until it is done
+    m_ready.acquire();
+}
+
+void RenderThread::initializeGL()
+{
+    m_context->makeCurrent(m_window);
+    m_renderer->initializeGL();
+}
+
+void RenderThread::submit(ImDrawData *drawData, const ImVec4 &clearColor)
+{
+    if (!m_context)
+        return;
+
+    if (!m_threaded) {
+        m_context->makeCurrent(m_window);
+        renderFrame(drawData, clearColor);
+        return;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_inFlight == 2)
+            m_cond.wait(&m_mutex);
+        m_inFlight++;
+    }
+
+    // Nothing renders the ImGui draw data after us, swap buffers instead of copying them
+    Frame frame;
+    frame.snapshot = m_renderer->takeSnapshot(drawData, DrawDataSnapshot::Swap);
+    frame.clearColor = clearColor;
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_queue[m_queueSize++] = frame;
+        m_cond.wakeAll();
+    }
+}
+
+void RenderThread::run()
+{
+    initializeGL();
+    m_ready.release();
+
+    forever {
+        Frame frame;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!m_quit && m_queueSize == 0)
+                m_cond.wait(&m_mutex);
+            if (m_quit)
+                break;
+            frame = m_queue[0];
+            m_queue[0] = m_queue[1];
+            m_queueSize--;
+        }
+
+        renderFrame(frame.snapshot->drawData(), frame.clearColor);
+        m_renderer->releaseSnapshot(frame.snapshot);
+
+        {
+            QMutexLocker lock(&m_mutex);
+            m_inFlight--;
+            m_cond.wakeAll();
+        }
+    }
+
+    // Frames still queued go back to the pool
+    for (int i = 0; i < m_queueSize; i++)
+        m_renderer->releaseSnapshot(m_queue[i].snapshot);
+    m_queueSize = 0;
+
+    // While the context is still current, the renderer cannot make it current from here
+    m_renderer->releaseGL();
+    m_context->doneCurrent();
+    m_context.reset();
+}
+
+void RenderThread::renderFrame(ImDrawData *drawData, const ImVec4 &clearColor)
+{
+    QTIMGUI_ZONE("QtImGui renderFrame");
+    QOpenGLFunctions *f = m_context->functions();
+    const int fb_width = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+    const int fb_height = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+
+    f->glBindFramebuffer(GL_FRAMEBUFFER, m_context->defaultFramebufferObject());
+    f->glViewport(0, 0, fb_width, fb_height);
+    f->glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
+    f->glClear(GL_COLOR_BUFFER_BIT);
+
+    m_renderer->renderDrawData(drawData);
+
+    if (m_window->isExposed()) {
+        QTIMGUI_ZONE("QtImGui swapBuffers");
+        m_context->swapBuffers(m_window);
+    }
+}
+
+} // namespace QtImGui
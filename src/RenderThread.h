@@ -0,0 +1,68 @@
+#pragma once
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <QWaitCondition>
+#include <imgui.h>
+#include <memory>
+
+class QOpenGLContext;
+class QWindow;
+
+namespace QtImGui {
+
+class DrawDataSnapshot;
+class ImGuiRenderer;
+
+// Submits ImGui frames to a window from a dedicated thread owning the window's GL context.
+//
+// The GUI thread hands over frames with submit(), which takes a pooled snapshot of the
+// draw data, so frame N+1 can be built while frame N is being rendered. At most two
+// frames are in flight, submit() blocks until the render thread is done with one of them.
+//
+// When the platform does not support threaded OpenGL, frames are rendered synchronously
+// by submit() instead.
+class RenderThread : public QThread {
+public:
+    RenderThread(ImGuiRenderer *renderer, QWindow *window);
+    ~RenderThread();
+
+    // Creates the GL context and device objects, returns once the first frame can be submitted.
+    // The ImGui context must be current and is accessed by the render thread until this returns.
+    void startRendering();
+
+    // Called on the GUI thread after ImGui::Render()
+    void submit(ImDrawData *drawData, const ImVec4 &clearColor);
+
+    bool isThreaded() const { return m_threaded; }
+
+protected:
+    void run() override;
+
+private:
+    void initializeGL();
+    void renderFrame(ImDrawData *drawData, const ImVec4 &clearColor);
+
+    ImGuiRenderer *m_renderer;
+    QWindow *m_window;
+    std::unique_ptr<QOpenGLContext> m_context;
+    bool m_threaded = false;
+
+    struct Frame {
+        DrawDataSnapshot *snapshot;
+        ImVec4 clearColor;
+    };
+
+    // Frames waiting for the render thread, m_inFlight also counts the one being drawn
+    Frame m_queue[2];
+    int m_queueSize = 0;
+    int m_inFlight = 0;
+    bool m_quit = false;
+
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QSemaphore m_ready;
+};
+
+} // namespace QtImGui
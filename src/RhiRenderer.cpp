@@ -0,0 +1,378 @@
+#include "RhiRenderer.h"
+
+#include <QFile>
+#include <QMatrix4x4>
+#include <QOffscreenSurface>
+#include <QVarLengthArray>
+#include <QWindow>
+#include <rhi/qrhi.h>
+#if QT_CONFIG(vulkan)
+#include <QVulkanInstance>
+#endif
+#include <cstddef>
+
+namespace QtImGui {
+
+namespace {
+
+QShader loadShader(const QString &name)
+{
+    QFile f(name);
+    if (f.open(QIODevice::ReadOnly))
+        return QShader::fromSerialized(f.readAll());
+    qWarning("QtImGui: failed to load shader %s", qPrintable(name));
+    return QShader();
+}
+
+// Shader resource bindings of textures not drawn for this many frames are deleted
+const quint64 kBindingsLifetimeFrames = 120;
+
+// Index buffer offsets must be 4-byte aligned on some APIs (Metal)
+quint32 alignIndexOffset(quint32 offset)
+{
+    return (offset + 3u) & ~3u;
+}
+
+} // namespace
+
+RhiRenderer::RhiRenderer(QWindow *window, RhiApi api)
+    : m_window(window)
+    , m_api(api)
+{
+}
+
+RhiRenderer::~RhiRenderer()
+{
+    // Resources must go before the QRhi
+    for (auto it = m_bindings.cbegin(); it != m_bindings.cend(); ++it)
+        delete it->srb;
+    m_bindings.clear();
+    m_pipeline.reset();
+    m_sampler.reset();
+    m_fontTexture.reset();
+    m_uniformBuffer.reset();
+    m_indexBuffer.reset();
+    m_vertexBuffer.reset();
+    m_offscreenTarget.reset();
+    m_offscreenTexture.reset();
+    m_swapChain.reset();
+    m_renderPass.reset();
+    m_rhi.reset();
+}
+
+bool RhiRenderer::createRhi()
+{
+    switch (m_api) {
+    case RhiApi::OpenGL: {
+        if (!m_window->handle())
+            m_window->setSurfaceType(QSurface::OpenGLSurface);
+        m_fallbackSurface.reset(QRhiGles2InitParams::newFallbackSurface());
+        QRhiGles2InitParams params;
+        params.fallbackSurface = m_fallbackSurface.get();
+        params.window = m_window;
+        m_rhi.reset(QRhi::create(QRhi::OpenGLES2, &params));
+        break;
+    }
+    case RhiApi::Vulkan: {
+#if QT_CONFIG(vulkan)
+        m_vulkanInstance.reset(new QVulkanInstance());
+        m_vulkanInstance->setExtensions(QRhiVulkanInitParams::preferredInstanceExtensions());
+        if (!m_vulkanInstance->create()) {
+            qWarning("QtImGui: failed to create a Vulkan instance");
+            return false;
+        }
+        if (!m_window->handle())
+            m_window->setSurfaceType(QSurface::VulkanSurface);
+        m_window->setVulkanInstance(m_vulkanInstance.get());
+        QRhiVulkanInitParams params;
+        params.inst = m_vulkanInstance.get();
+        params.window = m_window;
+        m_rhi.reset(QRhi::create(QRhi::Vulkan, &params));
+#else
+        qWarning("QtImGui: Qt was built without Vulkan support");
+#endif
+        break;
+    }
+    case RhiApi::Null: {
+        QRhiNullInitParams params;
+        m_rhi.reset(QRhi::create(QRhi::Null, &params));
+        break;
+    }
+    }
+
+    if (!m_rhi) {
+        qWarning("QtImGui: failed to create the QRhi");
+        return false;
+    }
+
+    if (m_api == RhiApi::Null) {
+        // No presentation: render into a texture of the window size
+        m_offscreenTexture.reset(m_rhi->newTexture(QRhiTexture::RGBA8, QSize(1, 1), 1, QRhiTexture::RenderTarget));
+        m_offscreenTexture->create();
+        m_offscreenTarget.reset(m_rhi->newTextureRenderTarget({ m_offscreenTexture.get() }));
+        m_renderPass.reset(m_offscreenTarget->newCompatibleRenderPassDescriptor());
+        m_offscreenTarget->setRenderPassDescriptor(m_renderPass.get());
+        m_offscreenTarget->create();
+    } else {
+        if (!m_window->handle())
+            m_window->create();
+        m_swapChain.reset(m_rhi->newSwapChain());
+        m_swapChain->setWindow(m_window);
+        m_renderPass.reset(m_swapChain->newCompatibleRenderPassDescriptor());
+        m_swapChain->setRenderPassDescriptor(m_renderPass.get());
+        m_swapChain->createOrResize();
+    }
+    return true;
+}
+
+bool RhiRenderer::createDeviceObjects()
+{
+    if (!m_rhi && !createRhi())
+        return false;
+
+    // Build texture atlas, it is uploaded with the first frame
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    m_pendingFontImage = QImage(pixels, width, height, width * 4, QImage::Format_RGBA8888).copy();
+
+    m_fontTexture.reset(m_rhi->newTexture(QRhiTexture::RGBA8, QSize(width, height)));
+    m_fontTexture->create();
+    io.Fonts->TexID = (ImTextureID)m_fontTexture.get();
+
+    m_sampler.reset(m_rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None,
+                                      QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge));
+    m_sampler->create();
+
+    m_uniformBuffer.reset(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64));
+    m_uniformBuffer->create();
+
+    // Shaders are baked to .qsb packages at build time by qt_add_shaders()
+    QRhiGraphicsPipeline::TargetBlend blend;
+    blend.enable = true;
+    blend.srcColor = QRhiGraphicsPipeline::SrcAlpha;
+    blend.dstColor = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+    blend.srcAlpha = QRhiGraphicsPipeline::One;
+    blend.dstAlpha = QRhiGraphicsPipeline::OneMinusSrcAlpha;
+
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({ { sizeof(ImDrawVert) } });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, quint32(offsetof(ImDrawVert, pos)) },
+        { 0, 1, QRhiVertexInputAttribute::Float2, quint32(offsetof(ImDrawVert, uv)) },
+        { 0, 2, QRhiVertexInputAttribute::UNormByte4, quint32(offsetof(ImDrawVert, col)) },
+    });
+
+    m_pipeline.reset(m_rhi->newGraphicsPipeline());
+    m_pipeline->setShaderStages({
+        { QRhiShaderStage::Vertex, loadShader(QStringLiteral(":/qtimgui/imgui.vert.qsb")) },
+        { QRhiShaderStage::Fragment, loadShader(QStringLiteral(":/qtimgui/imgui.frag.qsb")) },
+    });
+    m_pipeline->setVertexInputLayout(inputLayout);
+    m_pipeline->setTargetBlends({ blend });
+    m_pipeline->setCullMode(QRhiGraphicsPipeline::None);
+    m_pipeline->setFlags(QRhiGraphicsPipeline::UsesScissor);
+    m_pipeline->setShaderResourceBindings(bindingsFor(m_fontTexture.get()));
+    m_pipeline->setRenderPassDescriptor(m_renderPass.get());
+    if (!m_pipeline->create()) {
+        qWarning("QtImGui: failed to create the QRhi graphics pipeline");
+        m_pipeline.reset();
+        return false;
+    }
+    return true;
+}
+
+QRhiShaderResourceBindings *RhiRenderer::bindingsFor(QRhiTexture *texture)
+{
+    if (!texture)
+        return nullptr;
+
+    // Keyed by resource id: a texture allocated where a deleted one was is a new entry
+    Bindings &bindings = m_bindings[texture->globalResourceId()];
+    if (!bindings.srb) {
+        bindings.srb = m_rhi->newShaderResourceBindings();
+        bindings.srb->setBindings({
+            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage, m_uniformBuffer.get()),
+            QRhiShaderResourceBinding::sampledTexture(1, QRhiShaderResourceBinding::FragmentStage, texture, m_sampler.get()),
+        });
+        bindings.srb->create();
+    }
+    bindings.lastUsedFrame = m_frameIndex;
+    return bindings.srb;
+}
+
+void RhiRenderer::pruneBindings()
+{
+    // The font texture's bindings also define the pipeline layout
+    const quint64 font = m_fontTexture->globalResourceId();
+    for (auto it = m_bindings.begin(); it != m_bindings.end();) {
+        if (it.key() != font && m_frameIndex - it->lastUsedFrame > kBindingsLifetimeFrames) {
+            delete it->srb;
+            it = m_bindings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool RhiRenderer::ensureBufferSize(std::unique_ptr<QRhiBuffer> &buffer, quint32 size)
+{
+    if (buffer && buffer->size() >= size)
+        return true;
+
+    // Grow geometrically so that the buffers settle after a few frames
+    const quint32 capacity = qMax(size, buffer ? buffer->size() * 2 : 64u * 1024u);
+    const QRhiBuffer::UsageFlags usage = (&buffer == &m_vertexBuffer) ? QRhiBuffer::VertexBuffer : QRhiBuffer::IndexBuffer;
+    buffer.reset(m_rhi->newBuffer(QRhiBuffer::Dynamic, usage, capacity));
+    if (!buffer->create()) {
+        // Dropped so that the next frame tries again instead of using it
+        buffer.reset();
+        return false;
+    }
+    return true;
+}
+
+void RhiRenderer::resizeOffscreenTarget(const QSize &pixelSize)
+{
+    if (m_offscreenTexture->pixelSize() == pixelSize)
+        return;
+    m_offscreenTexture->setPixelSize(pixelSize);
+    m_offscreenTexture->create();
+    m_offscreenTarget->create();
+}
+
+void RhiRenderer::render(ImDrawData *drawData, const ImVec4 &clearColor)
+{
+    if (!m_pipeline)
+        return;
+
+    const int fb_width = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+    const int fb_height = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+    if (fb_width <= 0 || fb_height <= 0)
+        return;
+
+    QRhiCommandBuffer *cb = nullptr;
+    QRhiRenderTarget *rt = nullptr;
+    if (m_swapChain) {
+        if (m_swapChain->currentPixelSize() != m_swapChain->surfacePixelSize())
+            m_swapChain->createOrResize();
+        QRhi::FrameOpResult result = m_rhi->beginFrame(m_swapChain.get());
+        if (result == QRhi::FrameOpSwapChainOutOfDate) {
+            m_swapChain->createOrResize();
+            result = m_rhi->beginFrame(m_swapChain.get());
+        }
+        if (result != QRhi::FrameOpSuccess)
+            return;
+        cb = m_swapChain->currentFrameCommandBuffer();
+        rt = m_swapChain->currentFrameRenderTarget();
+    } else {
+        resizeOffscreenTarget(QSize(fb_width, fb_height));
+        if (m_rhi->beginOffscreenFrame(&cb) != QRhi::FrameOpSuccess)
+            return;
+        rt = m_offscreenTarget.get();
+    }
+
+    // Upload all lists into the persistent buffers, indices 4-byte aligned per list
+    quint32 vtx_size = 0, idx_size = 0;
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = drawData->CmdLists[n];
+        vtx_size += quint32(cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        idx_size = alignIndexOffset(idx_size) + quint32(cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+    }
+    if (!ensureBufferSize(m_vertexBuffer, qMax(vtx_size, 1u)) || !ensureBufferSize(m_indexBuffer, qMax(idx_size, 1u))) {
+        // Checked before taking an update batch, the pending font upload waits for the next frame
+        qWarning("QtImGui: cannot allocate the QRhi vertex or index buffer (%u, %u bytes), frame skipped",
+                 vtx_size, idx_size);
+        if (m_swapChain)
+            m_rhi->endFrame(m_swapChain.get());
+        else
+            m_rhi->endOffscreenFrame();
+        return;
+    }
+
+    QRhiResourceUpdateBatch *updates = m_rhi->nextResourceUpdateBatch();
+    if (!m_pendingFontImage.isNull()) {
+        updates->uploadTexture(m_fontTexture.get(), m_pendingFontImage);
+        m_pendingFontImage = QImage();
+    }
+
+    QVarLengthArray<quint32, 64> vtx_offsets, idx_offsets;
+    quint32 vtx_offset = 0, idx_offset = 0;
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = drawData->CmdLists[n];
+        const quint32 vbytes = quint32(cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        const quint32 ibytes = quint32(cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+        idx_offset = alignIndexOffset(idx_offset);
+        vtx_offsets.append(vtx_offset);
+        idx_offsets.append(idx_offset);
+        updates->updateDynamicBuffer(m_vertexBuffer.get(), vtx_offset, vbytes, cmd_list->VtxBuffer.Data);
+        updates->updateDynamicBuffer(m_indexBuffer.get(), idx_offset, ibytes, cmd_list->IdxBuffer.Data);
+        vtx_offset += vbytes;
+        idx_offset += ibytes;
+    }
+
+    // Orthographic projection covering the display rect, corrected for the API's clip space
+    QMatrix4x4 mvp = m_rhi->clipSpaceCorrMatrix();
+    mvp.ortho(drawData->DisplayPos.x, drawData->DisplayPos.x + drawData->DisplaySize.x,
+              drawData->DisplayPos.y + drawData->DisplaySize.y, drawData->DisplayPos.y,
+              -1.0f, 1.0f);
+    updates->updateDynamicBuffer(m_uniformBuffer.get(), 0, 64, mvp.constData());
+
+    const QColor clear = QColor::fromRgbF(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
+    cb->beginPass(rt, clear, { 1.0f, 0 }, updates);
+    cb->setGraphicsPipeline(m_pipeline.get());
+    cb->setViewport(QRhiViewport(0, 0, fb_width, fb_height));
+
+    const ImVec2 clip_off = drawData->DisplayPos;
+    const ImVec2 clip_scale = drawData->FramebufferScale;
+    const QRhiCommandBuffer::IndexFormat index_format = sizeof(ImDrawIdx) == 2 ? QRhiCommandBuffer::IndexUInt16 : QRhiCommandBuffer::IndexUInt32;
+
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = drawData->CmdLists[n];
+        const QRhiCommandBuffer::VertexInput vertex_input(m_vertexBuffer.get(), vtx_offsets[n]);
+        cb->setVertexInput(0, 1, &vertex_input, m_indexBuffer.get(), idx_offsets[n], index_format);
+
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback) {
+                // Raw GL callbacks cannot run here, only the reset request is meaningful
+                if (pcmd->UserCallback == ImDrawCallback_ResetRenderState) {
+                    cb->setGraphicsPipeline(m_pipeline.get());
+                    cb->setViewport(QRhiViewport(0, 0, fb_width, fb_height));
+                    cb->setVertexInput(0, 1, &vertex_input, m_indexBuffer.get(), idx_offsets[n], index_format);
+                }
+                continue;
+            }
+
+            const float x1 = qMax(0.0f, (pcmd->ClipRect.x - clip_off.x) * clip_scale.x);
+            const float y1 = qMax(0.0f, (pcmd->ClipRect.y - clip_off.y) * clip_scale.y);
+            const float x2 = qMin(float(fb_width), (pcmd->ClipRect.z - clip_off.x) * clip_scale.x);
+            const float y2 = qMin(float(fb_height), (pcmd->ClipRect.w - clip_off.y) * clip_scale.y);
+            if (x2 <= x1 || y2 <= y1)
+                continue;
+
+            // Commands without a texture have nothing to sample
+            QRhiShaderResourceBindings *srb = bindingsFor(static_cast<QRhiTexture*>(pcmd->TextureId));
+            if (!srb)
+                continue;
+
+            // QRhiScissor has a bottom-left origin, like glScissor
+            cb->setShaderResources(srb);
+            cb->setScissor(QRhiScissor(int(x1), int(fb_height - y2), int(x2 - x1), int(y2 - y1)));
+            cb->drawIndexed(pcmd->ElemCount, 1, pcmd->IdxOffset, qint32(pcmd->VtxOffset));
+        }
+    }
+
+    cb->endPass();
+
+    if (m_swapChain)
+        m_rhi->endFrame(m_swapChain.get());
+    else
+        m_rhi->endOffscreenFrame();
+
+    if (++m_frameIndex % kBindingsLifetimeFrames == 0)
+        pruneBindings();
+}
+
+} // namespace QtImGui
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "QtImGui.h"
+#include "RenderBackend.h"
+#include <QHash>
+#include <QImage>
+#include <memory>
+
+class QOffscreenSurface;
+class QRhi;
+class QRhiBuffer;
+class QRhiGraphicsPipeline;
+class QRhiRenderPassDescriptor;
+class QRhiRenderTarget;
+class QRhiSampler;
+class QRhiShaderResourceBindings;
+class QRhiSwapChain;
+class QRhiTexture;
+class QRhiTextureRenderTarget;
+class QVulkanInstance;
+class QWindow;
+
+namespace QtImGui {
+
+// QRhi backend (Qt >= 6.6): OpenGL, Vulkan, or the Null backend for measuring CPU cost.
+//
+// Vertices, indices and the projection go to persistent dynamic buffers that only grow,
+// the pipeline is built once. Shader resource bindings are cached per texture and
+// dropped once the texture has not been drawn for a while. With a window the backend
+// owns its swapchain; the Null backend renders into an offscreen texture of the window
+// size instead.
+// ImTextureID values are QRhiTexture pointers.
+class RhiRenderer : public RenderBackend {
+public:
+    RhiRenderer(QWindow *window, RhiApi api);
+    ~RhiRenderer();
+
+    bool createDeviceObjects() override;
+    void render(ImDrawData *drawData, const ImVec4 &clearColor) override;
+
+    QRhi *rhi() const { return m_rhi.get(); }
+
+private:
+    bool createRhi();
+    bool ensureBufferSize(std::unique_ptr<QRhiBuffer> &buffer, quint32 size);
+    QRhiShaderResourceBindings *bindingsFor(QRhiTexture *texture);
+    void pruneBindings();
+    void resizeOffscreenTarget(const QSize &pixelSize);
+
+    QWindow *m_window;
+    RhiApi m_api;
+
+    std::unique_ptr<QVulkanInstance> m_vulkanInstance;
+    std::unique_ptr<QOffscreenSurface> m_fallbackSurface;
+    std::unique_ptr<QRhi> m_rhi;
+    std::unique_ptr<QRhiSwapChain> m_swapChain;
+    std::unique_ptr<QRhiTexture> m_offscreenTexture;
+    std::unique_ptr<QRhiTextureRenderTarget> m_offscreenTarget;
+    std::unique_ptr<QRhiRenderPassDescriptor> m_renderPass;
+
+    std::unique_ptr<QRhiBuffer> m_vertexBuffer;
+    std::unique_ptr<QRhiBuffer> m_indexBuffer;
+    std::unique_ptr<QRhiBuffer> m_uniformBuffer;
+    std::unique_ptr<QRhiTexture> m_fontTexture;
+    std::unique_ptr<QRhiSampler> m_sampler;
+    std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
+    struct Bindings {
+        QRhiShaderResourceBindings *srb = nullptr;
+        quint64 lastUsedFrame = 0;
+    };
+    QHash<quint64, Bindings> m_bindings;    // By QRhiTexture::globalResourceId()
+    quint64 m_frameIndex = 0;
+    QImage m_pendingFontImage;  // Uploaded with the next frame
+};
+
+} // namespace QtImGui
@@ -0,0 +1,353 @@
+#include "SoftwareRasterizer.h"
+#include "Trace.h"
+
+#include <QBackingStore>
+#include <QPainter>
+#include <QThread>
+#include <QWindow>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QTIMGUI_RASTER_SSE2
+#endif
+
+namespace QtImGui {
+
+namespace {
+
+class TileWorker : public QRunnable {
+public:
+    explicit TileWorker(std::function<void()> work)
+      : m_work(std::move(work))
+    {
+        setAutoDelete(false);
+    }
+    void run() override { m_work(); }
+
+private:
+    std::function<void()> m_work;
+};
+
+// Attribute plane through three vertices: value at (x0, y0), d/dx, d/dy
+void setupPlane(float plane[3], float a0, float a1, float a2,
+                float dx1, float dy1, float dx2, float dy2, float invDet)
+{
+    plane[0] = a0;
+    plane[1] = ((a1 - a0) * dy2 - (a2 - a0) * dy1) * invDet;
+    plane[2] = ((a2 - a0) * dx1 - (a1 - a0) * dx2) * invDet;
+}
+
+inline float evalPlane(const float plane[3], float dx, float dy)
+{
+    return plane[0] + plane[1] * dx + plane[2] * dy;
+}
+
+inline quint32 fetchTexel(const QImage *texture, float u, float v)
+{
+    const int w = texture->width(), h = texture->height();
+    const int x = qBound(0, int(std::floor(u * w)), w - 1);
+    const int y = qBound(0, int(std::floor(v * h)), h - 1);
+    return reinterpret_cast<const quint32*>(texture->constScanLine(y))[x];
+}
+
+// Channels of an ImU32 / Format_RGBA8888 texel on little endian: R in the low byte
+inline int channel(quint32 c, int i)
+{
+    return int((c >> (8 * i)) & 0xff);
+}
+
+inline int mul255(int a, int b)
+{
+    const int t = a * b + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// Source-over onto an opaque Format_RGB32 pixel, the GL path's SrcAlpha / OneMinusSrcAlpha
+inline void blend(QRgb *dst, int r, int g, int b, int a)
+{
+    if (a == 0)
+        return;
+    if (a == 255) {
+        *dst = qRgb(r, g, b);
+        return;
+    }
+    const QRgb d = *dst;
+    const int ia = 255 - a;
+    *dst = qRgb(mul255(r, a) + mul255(qRed(d), ia),
+                mul255(g, a) + mul255(qGreen(d), ia),
+                mul255(b, a) + mul255(qBlue(d), ia));
+}
+
+} // namespace
+
+SoftwareRasterizer::SoftwareRasterizer(QWindow *window, int threadCount)
+    : m_window(window)
+    , m_nextTile(0)
+{
+    // The calling thread rasterizes too, the pool only provides the extra threads
+    if (threadCount <= 0)
+        threadCount = QThread::idealThreadCount();
+    m_pool.setMaxThreadCount(qMax(1, threadCount - 1));
+    for (int i = 0; i < m_pool.maxThreadCount(); i++)
+        m_workers.emplace_back(new TileWorker([this]() { rasterizeTiles(); }));
+
+    if (m_window) {
+        if (!m_window->handle())
+            m_window->setSurfaceType(QSurface::RasterSurface);
+        m_backingStore.reset(new QBackingStore(m_window));
+    }
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+    m_pool.waitForDone();
+}
+
+bool SoftwareRasterizer::createDeviceObjects()
+{
+    // Keep a CPU copy of the atlas, the ImGui owned pixels may be cleared by the app
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    m_fontImage = QImage(pixels, width, height, width * 4, QImage::Format_RGBA8888).copy();
+    io.Fonts->TexID = (ImTextureID)&m_fontImage;
+    return true;
+}
+
+void SoftwareRasterizer::render(ImDrawData *drawData, const ImVec4 &clearColor)
+{
+    const int fb_width = (int)(drawData->DisplaySize.x * drawData->FramebufferScale.x);
+    const int fb_height = (int)(drawData->DisplaySize.y * drawData->FramebufferScale.y);
+    if (fb_width <= 0 || fb_height <= 0)
+        return;
+
+    if (m_image.size() != QSize(fb_width, fb_height))
+        m_image = QImage(fb_width, fb_height, QImage::Format_RGB32);
+    m_clearPixel = qRgb(qBound(0, int(clearColor.x * 255.0f + 0.5f), 255),
+                        qBound(0, int(clearColor.y * 255.0f + 0.5f), 255),
+                        qBound(0, int(clearColor.z * 255.0f + 0.5f), 255));
+
+    {
+        QTIMGUI_ZONE("QtImGui setupTriangles");
+        setupTriangles(drawData, fb_width, fb_height);
+    }
+
+    m_nextTile.store(0);
+    const int helpers = qMin(int(m_workers.size()), m_tilesX * m_tilesY - 1);
+    for (int i = 0; i < helpers; i++)
+        m_pool.start(m_workers[i].get());
+    rasterizeTiles();
+    m_pool.waitForDone();
+
+    if (m_backingStore)
+        present();
+}
+
+void SoftwareRasterizer::setupTriangles(ImDrawData *drawData, int fbWidth, int fbHeight)
+{
+    m_tilesX = (fbWidth + TileSize - 1) / TileSize;
+    m_tilesY = (fbHeight + TileSize - 1) / TileSize;
+    const size_t tileCount = size_t(m_tilesX) * size_t(m_tilesY);
+    if (m_bins.size() < tileCount)
+        m_bins.resize(tileCount);
+    for (size_t i = 0; i < tileCount; i++)
+        m_bins[i].clear();
+    m_triangles.clear();
+
+    const ImVec2 clip_off = drawData->DisplayPos;
+    const ImVec2 clip_scale = drawData->FramebufferScale;
+
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList* cmd_list = drawData->CmdLists[n];
+        const ImDrawVert* vtx_buffer = cmd_list->VtxBuffer.Data;
+        const ImDrawIdx* idx_buffer = cmd_list->IdxBuffer.Data;
+
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++) {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            // There is no GPU state to reset or hand to a callback
+            if (pcmd->UserCallback)
+                continue;
+
+            const int clipX1 = qMax(0, int(std::floor((pcmd->ClipRect.x - clip_off.x) * clip_scale.x)));
+            const int clipY1 = qMax(0, int(std::floor((pcmd->ClipRect.y - clip_off.y) * clip_scale.y)));
+            const int clipX2 = qMin(fbWidth, int(std::ceil((pcmd->ClipRect.z - clip_off.x) * clip_scale.x)));
+            const int clipY2 = qMin(fbHeight, int(std::ceil((pcmd->ClipRect.w - clip_off.y) * clip_scale.y)));
+            if (clipX2 <= clipX1 || clipY2 <= clipY1)
+                continue;
+
+            const QImage *texture = static_cast<const QImage*>(pcmd->TextureId);
+            if (!texture || texture->isNull())
+                continue;
+
+            for (unsigned int i = 0; i + 2 < pcmd->ElemCount; i += 3) {
+                const ImDrawVert *v[3] = {
+                    &vtx_buffer[pcmd->VtxOffset + idx_buffer[pcmd->IdxOffset + i]],
+                    &vtx_buffer[pcmd->VtxOffset + idx_buffer[pcmd->IdxOffset + i + 1]],
+                    &vtx_buffer[pcmd->VtxOffset + idx_buffer[pcmd->IdxOffset + i + 2]],
+                };
+                float x[3], y[3];
+                for (int k = 0; k < 3; k++) {
+                    x[k] = (v[k]->pos.x - clip_off.x) * clip_scale.x;
+                    y[k] = (v[k]->pos.y - clip_off.y) * clip_scale.y;
+                }
+
+                float det = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (det == 0.0f)
+                    continue;
+                // No culling: flip clockwise triangles so the inside is always positive
+                if (det < 0.0f) {
+                    std::swap(v[1], v[2]);
+                    std::swap(x[1], x[2]);
+                    std::swap(y[1], y[2]);
+                    det = -det;
+                }
+
+                Triangle t;
+                t.minX = qMax(clipX1, int(std::floor(std::min({ x[0], x[1], x[2] }))));
+                t.minY = qMax(clipY1, int(std::floor(std::min({ y[0], y[1], y[2] }))));
+                t.maxX = qMin(clipX2 - 1, int(std::ceil(std::max({ x[0], x[1], x[2] }))));
+                t.maxY = qMin(clipY2 - 1, int(std::ceil(std::max({ y[0], y[1], y[2] }))));
+                if (t.maxX < t.minX || t.maxY < t.minY)
+                    continue;
+
+                for (int k = 0; k < 3; k++) {
+                    const int a = k, b = (k + 1) % 3;
+                    t.edgeA[k] = -(y[b] - y[a]);
+                    t.edgeB[k] = x[b] - x[a];
+                    t.edgeC[k] = -(t.edgeA[k] * x[a] + t.edgeB[k] * y[a]);
+                    // Antisymmetric, so a pixel on a shared edge belongs to exactly one triangle
+                    const bool topLeft = t.edgeA[k] > 0.0f || (t.edgeA[k] == 0.0f && t.edgeB[k] < 0.0f);
+                    t.edgeBias[k] = topLeft ? 0.0f : std::numeric_limits<float>::min();
+                }
+
+                t.texture = texture;
+                t.isConstant = v[0]->col == v[1]->col && v[0]->col == v[2]->col
+                            && v[0]->uv.x == v[1]->uv.x && v[0]->uv.x == v[2]->uv.x
+                            && v[0]->uv.y == v[1]->uv.y && v[0]->uv.y == v[2]->uv.y;
+                if (t.isConstant) {
+                    const quint32 texel = fetchTexel(texture, v[0]->uv.x, v[0]->uv.y);
+                    for (int c = 0; c < 4; c++)
+                        t.constant[c] = mul255(channel(v[0]->col, c), channel(texel, c));
+                } else {
+                    const float dx1 = x[1] - x[0], dy1 = y[1] - y[0];
+                    const float dx2 = x[2] - x[0], dy2 = y[2] - y[0];
+                    const float invDet = 1.0f / det;
+                    t.x0 = x[0];
+                    t.y0 = y[0];
+                    setupPlane(t.u, v[0]->uv.x, v[1]->uv.x, v[2]->uv.x, dx1, dy1, dx2, dy2, invDet);
+                    setupPlane(t.v, v[0]->uv.y, v[1]->uv.y, v[2]->uv.y, dx1, dy1, dx2, dy2, invDet);
+                    for (int c = 0; c < 4; c++)
+                        setupPlane(t.col[c], float(channel(v[0]->col, c)), float(channel(v[1]->col, c)),
+                                   float(channel(v[2]->col, c)), dx1, dy1, dx2, dy2, invDet);
+                }
+
+                const quint32 index = quint32(m_triangles.size());
+                m_triangles.push_back(t);
+                for (int ty = t.minY / TileSize; ty <= t.maxY / TileSize; ty++)
+                    for (int tx = t.minX / TileSize; tx <= t.maxX / TileSize; tx++)
+                        m_bins[ty * m_tilesX + tx].push_back(index);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeTiles()
+{
+    QTIMGUI_ZONE("QtImGui rasterizeTiles");
+    const int tileCount = m_tilesX * m_tilesY;
+    for (int tile = m_nextTile.fetch_add(1); tile < tileCount; tile = m_nextTile.fetch_add(1))
+        rasterizeTile(tile);
+}
+
+void SoftwareRasterizer::rasterizeTile(int tileIndex)
+{
+    const int tileX0 = (tileIndex % m_tilesX) * TileSize;
+    const int tileY0 = (tileIndex / m_tilesX) * TileSize;
+    const int tileX1 = qMin(tileX0 + TileSize, m_image.width()) - 1;
+    const int tileY1 = qMin(tileY0 + TileSize, m_image.height()) - 1;
+
+    // Tiles own disjoint pixels, so clearing here keeps the clear parallel as well
+    for (int y = tileY0; y <= tileY1; y++)
+        std::fill_n(reinterpret_cast<QRgb*>(m_image.scanLine(y)) + tileX0, tileX1 - tileX0 + 1, m_clearPixel);
+
+    for (quint32 index : m_bins[tileIndex]) {
+        const Triangle &t = m_triangles[index];
+        const int minX = qMax(t.minX, tileX0), maxX = qMin(t.maxX, tileX1);
+        const int minY = qMax(t.minY, tileY0), maxY = qMin(t.maxY, tileY1);
+
+        for (int y = minY; y <= maxY; y++) {
+            QRgb *line = reinterpret_cast<QRgb*>(m_image.scanLine(y));
+            const float py = float(y) + 0.5f;
+            float rowE[3];
+            for (int k = 0; k < 3; k++)
+                rowE[k] = t.edgeB[k] * py + t.edgeC[k];
+
+            for (int x = minX; x <= maxX; x += 4) {
+                // Coverage of the pixel centers x .. x+3, bit i set when pixel x+i is inside
+                int mask;
+#ifdef QTIMGUI_RASTER_SSE2
+                const __m128 px = _mm_add_ps(_mm_set1_ps(float(x) + 0.5f), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (int k = 0; k < 3; k++) {
+                    const __m128 e = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[k]), px), _mm_set1_ps(rowE[k]));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(e, _mm_set1_ps(t.edgeBias[k])));
+                }
+                mask = _mm_movemask_ps(inside);
+#else
+                mask = 0;
+                for (int i = 0; i < 4; i++) {
+                    const float px = float(x + i) + 0.5f;
+                    bool in = true;
+                    for (int k = 0; k < 3; k++)
+                        in = in && t.edgeA[k] * px + rowE[k] >= t.edgeBias[k];
+                    mask |= int(in) << i;
+                }
+#endif
+                mask &= (1 << qMin(4, maxX - x + 1)) - 1;
+                if (!mask)
+                    continue;
+
+                for (int i = 0; i < 4; i++) {
+                    if (!(mask & (1 << i)))
+                        continue;
+                    QRgb *dst = line + x + i;
+                    if (t.isConstant) {
+                        blend(dst, t.constant[0], t.constant[1], t.constant[2], t.constant[3]);
+                        continue;
+                    }
+                    const float dx = float(x + i) + 0.5f - t.x0, dy = py - t.y0;
+                    const quint32 texel = fetchTexel(t.texture, evalPlane(t.u, dx, dy), evalPlane(t.v, dx, dy));
+                    int c[4];
+                    for (int k = 0; k < 4; k++)
+                        c[k] = mul255(qBound(0, int(evalPlane(t.col[k], dx, dy) + 0.5f), 255), channel(texel, k));
+                    blend(dst, c[0], c[1], c[2], c[3]);
+                }
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::present()
+{
+    if (!m_window->isExposed())
+        return;
+
+    const QRect rect(QPoint(0, 0), m_window->size());
+    if (m_backingStore->size() != rect.size())
+        m_backingStore->resize(rect.size());
+
+    m_backingStore->beginPaint(rect);
+    {
+        QPainter painter(m_backingStore->paintDevice());
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(rect, m_image);
+    }
+    m_backingStore->endPaint();
+    m_backingStore->flush(rect);
+}
+
+} // namespace QtImGui
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "RenderBackend.h"
+#include <QImage>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QBackingStore;
+class QWindow;
+
+namespace QtImGui {
+
+// CPU backend: rasterizes ImDrawData into a QImage, without any GPU or GL driver.
+//
+// Triangles are set up once per frame and binned into square tiles. Tiles are then
+// rasterized in parallel on a private QThreadPool, each tile drawing its triangles in
+// submission order so blending matches the GL path. Coverage is computed with edge
+// functions, four pixels at a time with SSE2 when available.
+//
+// ImTextureID values are `const QImage *` in Format_RGBA8888 (the font atlas is kept
+// as such a copy). Textures are sampled with nearest filtering, which matches GL for
+// glyphs and rectangles drawn at integer device pixel ratios.
+//
+// With a window, each frame is presented through a QBackingStore; otherwise the
+// result is only available from image().
+class SoftwareRasterizer : public RenderBackend {
+public:
+    explicit SoftwareRasterizer(QWindow *window = nullptr, int threadCount = 0);
+    ~SoftwareRasterizer();
+
+    bool createDeviceObjects() override;
+    void render(ImDrawData *drawData, const ImVec4 &clearColor) override;
+
+    // Last rendered frame, in Format_RGB32 and framebuffer pixels
+    const QImage &image() const { return m_image; }
+
+    static const int TileSize = 64;
+
+private:
+    struct Triangle {
+        float edgeA[3], edgeB[3], edgeC[3];  // Edge functions A*x + B*y + C, >= bias inside
+        float edgeBias[3];                   // Top-left fill rule
+        int minX, minY, maxX, maxY;          // Bounds clipped to the scissor rect, inclusive
+        float x0, y0;                        // Origin of the attribute planes
+        float u[3], v[3];                    // Plane (value at origin, d/dx, d/dy)
+        float col[4][3];
+        const QImage *texture;
+        bool isConstant;                     // Same color and texel everywhere: rects, lines
+        int constant[4];                     // RGBA of a constant triangle
+    };
+
+    void setupTriangles(ImDrawData *drawData, int fbWidth, int fbHeight);
+    void rasterizeTiles();
+    void rasterizeTile(int tileIndex);
+    void present();
+
+    QWindow *m_window;
+    std::unique_ptr<QBackingStore> m_backingStore;
+    QImage m_fontImage;
+    QImage m_image;
+    QRgb m_clearPixel = 0;
+
+    QThreadPool m_pool;
+    std::vector<std::unique_ptr<QRunnable>> m_workers;
+    int m_tilesX = 0, m_tilesY = 0;
+    std::vector<Triangle> m_triangles;
+    std::vector<std::vector<quint32>> m_bins;   // Triangle indices per tile, in draw order
+    std::atomic<int> m_nextTile;
+};
+
+} // namespace QtImGui
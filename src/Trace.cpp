@@ -0,0 +1,171 @@
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace QtImGui {
+namespace Trace {
+
+namespace {
+
+struct Event {
+    const char *name;
+    qint64 begin;
+    qint64 end;
+};
+
+// Written by its thread only; `head` counts the events ever written
+struct ThreadBuffer {
+    std::vector<Event> events = std::vector<Event>(size_t(kRingSize));
+    std::atomic<quint64> head { 0 };
+    std::atomic<quint64> clearedAt { 0 };
+    int id = 0;
+    QByteArray name;
+};
+
+struct Registry {
+    QMutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;   // Outlive their threads
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+std::atomic<bool> g_enabled { true };
+thread_local ThreadBuffer *t_buffer = nullptr;
+
+ThreadBuffer *threadBuffer()
+{
+    if (t_buffer)
+        return t_buffer;
+
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    QThread *thread = QThread::currentThread();
+    buffer->name = thread->objectName().toUtf8();
+    if (buffer->name.isEmpty() && QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        buffer->name = "GUI thread";
+
+    Registry &r = registry();
+    QMutexLocker lock(&r.mutex);
+    buffer->id = int(r.buffers.size()) + 1;
+    if (buffer->name.isEmpty())
+        buffer->name = "Thread " + QByteArray::number(buffer->id);
+    t_buffer = buffer.get();
+    r.buffers.push_back(std::move(buffer));
+    return t_buffer;
+}
+
+void appendEscaped(QByteArray &out, const char *text)
+{
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\')
+            out.append('\\');
+        if (uchar(*c) >= 0x20)
+            out.append(*c);
+    }
+}
+
+} // namespace
+
+void setEnabled(bool enabled)
+{
+    g_enabled = enabled;
+}
+
+bool isEnabled()
+{
+    return g_enabled;
+}
+
+qint64 now()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void record(const char *name, qint64 beginNs, qint64 endNs)
+{
+    if (!g_enabled.load(std::memory_order_relaxed))
+        return;
+
+    ThreadBuffer *buffer = threadBuffer();
+    const quint64 head = buffer->head.load(std::memory_order_relaxed);
+    Event &event = buffer->events[size_t(head % kRingSize)];
+    event.name = name;
+    event.begin = beginNs;
+    event.end = endNs;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void clear()
+{
+    Registry &r = registry();
+    QMutexLocker lock(&r.mutex);
+    for (const auto &buffer : r.buffers)
+        buffer->clearedAt = buffer->head.load(std::memory_order_acquire);
+}
+
+QByteArray chromeTraceJson()
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QByteArray out("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+    std::vector<Event> events;
+    char line[256];
+
+    Registry &r = registry();
+    QMutexLocker lock(&r.mutex);
+    for (const auto &buffer : r.buffers) {
+        out.append(first ? "" : ",");
+        first = false;
+        out.append("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" + QByteArray::number(pid)
+                   + ",\"tid\":" + QByteArray::number(buffer->id) + ",\"args\":{\"name\":\"");
+        appendEscaped(out, buffer->name.constData());
+        out.append("\"}}");
+
+        // Copy, then drop what the thread overwrote meanwhile
+        const quint64 head = buffer->head.load(std::memory_order_acquire);
+        const quint64 begin = std::max(buffer->clearedAt.load(), head > quint64(kRingSize) ? head - kRingSize : 0);
+        events.assign(size_t(head - begin), Event());
+        for (quint64 i = begin; i < head; i++)
+            events[size_t(i - begin)] = buffer->events[size_t(i % kRingSize)];
+        // The thread may also be writing slot newHead, which is that of event newHead - kRingSize
+        const quint64 newHead = buffer->head.load(std::memory_order_acquire);
+        const quint64 valid = newHead + 1 > quint64(kRingSize) ? newHead + 1 - kRingSize : 0;
+
+        for (quint64 i = std::max(begin, valid); i < head; i++) {
+            const Event &event = events[size_t(i - begin)];
+            std::snprintf(line, sizeof(line), ",{\"ph\":\"X\",\"pid\":%lld,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"",
+                          (long long)pid, buffer->id, event.begin / 1e3, (event.end - event.begin) / 1e3);
+            out.append(line);
+            appendEscaped(out, event.name);
+            out.append("\"}");
+        }
+    }
+    out.append("]}");
+    return out;
+}
+
+bool writeChromeTrace(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("QtImGui: cannot open %s for writing the trace", qPrintable(path));
+        return false;
+    }
+    return file.write(chromeTraceJson()) >= 0;
+}
+
+} // namespace Trace
+} // namespace QtImGui
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+// Scoped trace zones, exported as Chrome trace-event JSON (chrome://tracing, Perfetto).
+//
+//     void Panel::draw()
+//     {
+//         QTIMGUI_ZONE("Panel::draw");
+//         ...
+//     }
+//
+// Zones are recorded when the library and the code using the macro are built with
+// QTIMGUI_ENABLE_TRACE (CMake option of the same name, CONFIG += qtimgui_trace with qmake),
+// and compile to nothing otherwise. Names must be string literals, only the pointer is kept.
+#ifdef QTIMGUI_ENABLE_TRACE
+#define QTIMGUI_ZONE_CONCAT2(a, b) a##b
+#define QTIMGUI_ZONE_CONCAT(a, b) QTIMGUI_ZONE_CONCAT2(a, b)
+#define QTIMGUI_ZONE(name) QtImGui::Trace::Zone QTIMGUI_ZONE_CONCAT(qtimgui_zone_, __LINE__)(name)
+#else
+#define QTIMGUI_ZONE(name) ((void)0)
+#endif
+
+namespace QtImGui {
+namespace Trace {
+
+// Each thread records into its own ring of kRingSize zones, without locking; the oldest
+// zones are overwritten. Zones are stored when they end, so a dump only holds closed zones.
+const int kRingSize = 1 << 16;
+
+// Recording can be paused at runtime, it is on by default
+void setEnabled(bool enabled);
+bool isEnabled();
+
+// Zones of all threads as Chrome trace-event JSON. Safe while other threads record; zones
+// overwritten during the dump are left out.
+QByteArray chromeTraceJson();
+bool writeChromeTrace(const QString &path);
+
+// Drops the recorded zones
+void clear();
+
+// Monotonic nanoseconds since the first zone of the process
+qint64 now();
+
+void record(const char *name, qint64 beginNs, qint64 endNs);
+
+class Zone {
+public:
+    explicit Zone(const char *name) : m_name(name), m_begin(now()) {}
+    ~Zone() { record(m_name, m_begin, now()); }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_begin;
+};
+
+} // namespace Trace
+} // namespace QtImGui
@@ -0,0 +1,127 @@
+#include "ViewportPool.h"
+
+#include <QOpenGLFramebufferObject>
+
+namespace QtImGui {
+
+namespace {
+
+// Viewport sizes are rounded up to a multiple of this, in pixels
+const int kBucketGranularity = 128;
+
+// Number of frames a pooled FBO may stay unused before it is deleted
+const int kMaxIdleFrames = 120;
+
+// RGBA8 color plus combined 24-bit depth and 8-bit stencil
+const qint64 kBytesPerPixel = 4 + 4;
+
+int roundUpToBucket(int v)
+{
+    return qMax(1, (v + kBucketGranularity - 1) / kBucketGranularity) * kBucketGranularity;
+}
+
+} // namespace
+
+ViewportPool::ViewportPool()
+{
+}
+
+ViewportPool::~ViewportPool()
+{
+}
+
+QSize ViewportPool::bucketSize(const QSize &pixelSize)
+{
+    return QSize(roundUpToBucket(pixelSize.width()), roundUpToBucket(pixelSize.height()));
+}
+
+QOpenGLFramebufferObject *ViewportPool::acquire(ImGuiID id, const QSize &pixelSize)
+{
+    const QSize bucket = bucketSize(pixelSize);
+
+    auto it = m_slots.find(id);
+    if (it != m_slots.end()) {
+        Slot &slot = it->second;
+        if (slot.fbo->size() == bucket) {
+            slot.lastUsedFrame = m_frame;
+            m_stats.reuses++;
+            return slot.fbo.get();
+        }
+
+        // Bucket changed: give the old FBO back so another viewport can use it
+        m_pool.push_back(std::move(slot));
+        m_pool.back().lastUsedFrame = m_frame;
+        m_slots.erase(it);
+    }
+
+    Slot slot = takeFromPool(bucket);
+    if (slot.fbo) {
+        m_stats.reuses++;
+    } else {
+        QOpenGLFramebufferObjectFormat format;
+        format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+        slot.fbo.reset(new QOpenGLFramebufferObject(bucket, format));
+        m_stats.allocations++;
+    }
+    slot.lastUsedFrame = m_frame;
+
+    QOpenGLFramebufferObject *fbo = slot.fbo.get();
+    m_slots[id] = std::move(slot);
+    updateStats();
+    return fbo;
+}
+
+ViewportPool::Slot ViewportPool::takeFromPool(const QSize &bucket)
+{
+    for (auto it = m_pool.begin(); it != m_pool.end(); ++it) {
+        if (it->fbo->size() == bucket) {
+            Slot slot = std::move(*it);
+            m_pool.erase(it);
+            return slot;
+        }
+    }
+    return Slot();
+}
+
+void ViewportPool::endFrame()
+{
+    for (auto it = m_slots.begin(); it != m_slots.end();) {
+        if (it->second.lastUsedFrame != m_frame) {
+            m_pool.push_back(std::move(it->second));
+            it = m_slots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = m_pool.begin(); it != m_pool.end();) {
+        if (m_frame - it->lastUsedFrame > kMaxIdleFrames) {
+            it = m_pool.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    m_frame++;
+    updateStats();
+}
+
+void ViewportPool::clear()
+{
+    m_slots.clear();
+    m_pool.clear();
+    updateStats();
+}
+
+void ViewportPool::updateStats()
+{
+    m_stats.live = int(m_slots.size());
+    m_stats.pooled = int(m_pool.size());
+    m_stats.bytes = 0;
+    for (const auto &entry : m_slots)
+        m_stats.bytes += qint64(entry.second.fbo->width()) * entry.second.fbo->height() * kBytesPerPixel;
+    for (const Slot &slot : m_pool)
+        m_stats.bytes += qint64(slot.fbo->width()) * slot.fbo->height() * kBytesPerPixel;
+}
+
+} // namespace QtImGui
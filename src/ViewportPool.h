@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QSize>
+#include <imgui.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class QOpenGLFramebufferObject;
+
+namespace QtImGui {
+
+// Pool of framebuffer objects backing QtImGui::viewport().
+//
+// FBO sizes are rounded up to buckets, so a viewport keeps its FBO while it is
+// resized inside the same bucket. FBOs of viewports that are not drawn in a
+// frame go back to the pool and are reused by any viewport of the same bucket.
+class ViewportPool {
+public:
+    struct Stats {
+        int allocations = 0; // FBOs created since the pool was created
+        int reuses = 0;      // acquire() calls served without allocating
+        int live = 0;        // FBOs attached to a viewport
+        int pooled = 0;      // FBOs waiting in the pool
+        qint64 bytes = 0;    // Color and depth/stencil storage of live and pooled FBOs
+    };
+
+    ViewportPool();
+    ~ViewportPool();
+
+    // Returns the FBO of viewport `id`, large enough for `pixelSize`.
+    // Must be called with a current OpenGL context.
+    QOpenGLFramebufferObject *acquire(ImGuiID id, const QSize &pixelSize);
+
+    // Recycles the FBOs of viewports that were not drawn since the last call,
+    // and deletes pooled FBOs that stayed unused for too long.
+    void endFrame();
+
+    // Deletes all FBOs. Must be called with the owning context current.
+    void clear();
+
+    const Stats &stats() const { return m_stats; }
+
+    static QSize bucketSize(const QSize &pixelSize);
+
+private:
+    struct Slot {
+        std::unique_ptr<QOpenGLFramebufferObject> fbo;
+        int lastUsedFrame = 0;
+    };
+
+    Slot takeFromPool(const QSize &bucket);
+    void updateStats();
+
+    std::unordered_map<ImGuiID, Slot> m_slots;
+    std::vector<Slot> m_pool;
+    int m_frame = 0;
+    Stats m_stats;
+};
+
+} // namespace QtImGui
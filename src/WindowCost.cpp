@@ -0,0 +1,160 @@
+#include "WindowCost.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace QtImGui {
+
+namespace {
+
+// GPU time first when measured, uploads otherwise
+bool costlier(const WindowCost &a, const WindowCost &b)
+{
+    if (a.gpuMs != b.gpuMs)
+        return a.gpuMs > b.gpuMs;
+    return a.bytesUploaded > b.bytesUploaded;
+}
+
+} // namespace
+
+WindowCostTracker::WindowCostTracker()
+{
+}
+
+WindowCostTracker::Entry &WindowCostTracker::entry(const char *owner)
+{
+    // The key buffer is reused and entries outlive take(), only new windows allocate
+    m_key.assign(owner ? owner : "");
+    auto it = m_entries.find(m_key);
+    if (it == m_entries.end()) {
+        it = m_entries.emplace(m_key, Entry()).first;
+        it->second.name = QString::fromStdString(m_key);
+    }
+    it->second.seen = true;
+    return it->second;
+}
+
+void WindowCostTracker::addFrame(const ImDrawData *drawData)
+{
+    QMutexLocker lock(&m_mutex);
+    m_frames++;
+    for (int n = 0; n < drawData->CmdListsCount; n++) {
+        const ImDrawList *list = drawData->CmdLists[n];
+        Entry &e = entry(list->_OwnerName);
+        e.vertices += list->VtxBuffer.Size;
+        e.indices += list->IdxBuffer.Size;
+        e.bytes += qint64(list->VtxBuffer.Size) * sizeof(ImDrawVert) + qint64(list->IdxBuffer.Size) * sizeof(ImDrawIdx);
+        for (const ImDrawCmd &cmd : list->CmdBuffer)
+            e.commands += cmd.UserCallback ? 0 : 1;
+    }
+}
+
+void WindowCostTracker::addGpuTimes(const std::vector<ListGpuTime> &lists)
+{
+    QMutexLocker lock(&m_mutex);
+    for (const ListGpuTime &list : lists) {
+        Entry &e = entry(list.owner.c_str());
+        e.gpuMs += list.ms;
+        e.gpuSamples++;
+    }
+}
+
+WindowCosts WindowCostTracker::take()
+{
+    QMutexLocker lock(&m_mutex);
+    WindowCosts costs;
+    const double frames = qMax(1, m_frames);
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        // Windows absent for a whole interval are closed, they leave the table
+        if (!it->second.seen) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        Entry &e = it->second;
+        WindowCost cost;
+        cost.window = e.name;
+        cost.vertices = e.vertices / frames;
+        cost.indices = e.indices / frames;
+        cost.commands = e.commands / frames;
+        cost.bytesUploaded = e.bytes / frames;
+        cost.gpuMs = e.gpuSamples > 0 ? e.gpuMs / e.gpuSamples : -1.0;
+        costs.append(cost);
+
+        // Zeroed for the next interval, the name is kept
+        e.vertices = e.indices = e.commands = e.bytes = 0;
+        e.gpuMs = 0.0;
+        e.gpuSamples = 0;
+        e.seen = false;
+        ++it;
+    }
+    std::sort(costs.begin(), costs.end(), costlier);
+    m_frames = 0;
+    return costs;
+}
+
+void WindowCostTracker::drawWindow(const WindowCosts &costs, bool *open)
+{
+    if (!ImGui::Begin("Render profiler", open)) {
+        ImGui::End();
+        return;
+    }
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders
+                                | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("costs", 6, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Window", ImGuiTableColumnFlags_NoSort);
+        ImGui::TableSetupColumn("GPU ms", ImGuiTableColumnFlags_DefaultSort | ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Bytes", ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Vertices", ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Indices", ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableSetupColumn("Commands", ImGuiTableColumnFlags_PreferSortDescending);
+        ImGui::TableHeadersRow();
+
+        // Sorted on every draw, tables are small and this keeps the window stateless
+        std::vector<const WindowCost*> rows;
+        rows.reserve(size_t(costs.size()));
+        for (const WindowCost &cost : costs)
+            rows.push_back(&cost);
+        const ImGuiTableSortSpecs *specs = ImGui::TableGetSortSpecs();
+        if (specs && specs->SpecsCount > 0) {
+            const int column = specs->Specs[0].ColumnIndex;
+            const bool ascending = specs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+            auto key = [column](const WindowCost *c) {
+                switch (column) {
+                case 1: return c->gpuMs;
+                case 2: return c->bytesUploaded;
+                case 3: return c->vertices;
+                case 4: return c->indices;
+                default: return c->commands;
+                }
+            };
+            std::stable_sort(rows.begin(), rows.end(), [&](const WindowCost *a, const WindowCost *b) {
+                return ascending ? key(a) < key(b) : key(a) > key(b);
+            });
+        }
+
+        for (const WindowCost *cost : rows) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(cost->window.isEmpty() ? "(no window)" : qPrintable(cost->window));
+            ImGui::TableNextColumn();
+            if (cost->gpuMs >= 0.0)
+                ImGui::Text("%.3f", cost->gpuMs);
+            else
+                ImGui::TextDisabled("-");
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", cost->bytesUploaded);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", cost->vertices);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", cost->indices);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", cost->commands);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+} // namespace QtImGui
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QMetaType>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <imgui.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GpuTimer.h"
+
+namespace QtImGui {
+
+// Render cost of an ImGui window, averaged per frame over a reporting interval
+struct WindowCost {
+    QString window;             // Owner of the draw lists, empty for lists without one
+    double vertices = 0.0;
+    double indices = 0.0;
+    double commands = 0.0;      // Draw commands, callbacks excluded
+    double bytesUploaded = 0.0; // Vertex and index data sent to the GPU
+    double gpuMs = -1.0;        // -1 without GPU timing (ImGuiRenderer::setGpuTiming())
+};
+
+typedef QVector<WindowCost> WindowCosts;
+
+// Attributes the draw data of each frame to the windows owning its draw lists.
+// addFrame() and take() are called from the GUI thread, addGpuTimes() from the thread
+// drawing with GL.
+class WindowCostTracker {
+public:
+    WindowCostTracker();
+
+    void addFrame(const ImDrawData *drawData);
+    void addGpuTimes(const std::vector<ListGpuTime> &lists);
+
+    // Per-frame averages since the previous call, costliest first
+    WindowCosts take();
+
+    // ImGui table of `costs`, sortable by column, costliest first by default
+    static void drawWindow(const WindowCosts &costs, bool *open = nullptr);
+
+private:
+    struct Entry {
+        QString name;
+        qint64 vertices = 0;
+        qint64 indices = 0;
+        qint64 commands = 0;
+        qint64 bytes = 0;
+        double gpuMs = 0.0;
+        int gpuSamples = 0;
+        bool seen = false;      // Drawn during the current interval
+    };
+
+    Entry &entry(const char *owner);
+
+    QMutex m_mutex;
+    std::unordered_map<std::string, Entry> m_entries;   // Keyed by window name
+    std::string m_key;
+    int m_frames = 0;
+};
+
+} // namespace QtImGui
+
+Q_DECLARE_METATYPE(QtImGui::WindowCosts)